@@ -0,0 +1,424 @@
+# Build-time benchmark, run in script mode by the build_benchmark target (see CMakeLists.txt), which passes
+# SOURCE_ROOT, WORK_DIR, SAMPLES (comma separated), GENERATOR, MAKE_PROGRAM, CXX_COMPILER, CXX_COMPILER_ID,
+# CXX_COMPILER_VERSION, CXX_COMPILER_FRONTEND_VARIANT, TOOLCHAIN_FILE, BUILD_TYPE, REPEAT, OUTPUT, BASELINE and TOLERANCE.
+#
+# For every sample:
+#   configureMs          configure of an empty build directory, after an untimed one that installs the dependencies
+#   cleanBuildMs         full build right after that
+#   incrementalBuildMs   build after touching src/main.cpp
+#   linkMs               build after deleting the executable, i.e. the link step alone
+#   translationUnits     compile time (from -ftime-trace with Clang, wall time of the compile command otherwise)
+#                        and pre-processed line count of every translation unit
+#   headers              pre-processed line count of the sample's heavy headers, each included on its own
+#
+# With REPEAT > 1 every measurement keeps its fastest run.
+
+cmake_minimum_required(VERSION 3.29 FATAL_ERROR)
+
+# headers whose pre-processed size is reported on their own
+set(HEADERS_directx12 "d3dx12.h;d3d12.h;windows.h")
+set(HEADERS_opengl_glfw "glad/glad.h;GLFW/glfw3.h")
+set(HEADERS_opengl_sdl3 "glad/glad.h;SDL3/SDL.h")
+set(HEADERS_vulkan_glfw "vulkan/vulkan.h;GLFW/glfw3.h;glm/glm.hpp")
+
+set(METRICS configureMs cleanBuildMs incrementalBuildMs linkMs preprocessedLines)
+
+string(REPLACE "," ";" SAMPLES "${SAMPLES}")
+
+if(NOT REPEAT OR REPEAT LESS 1)
+    set(REPEAT 1)
+endif()
+
+if(CXX_COMPILER_ID MATCHES "Clang" AND NOT CXX_COMPILER_FRONTEND_VARIANT STREQUAL "MSVC")
+    set(USE_TIME_TRACE ON)
+else()
+    set(USE_TIME_TRACE OFF)
+endif()
+
+if(CXX_COMPILER_FRONTEND_VARIANT STREQUAL "MSVC")
+    set(PREPROCESS_FLAGS "/EP")
+    set(INCLUDE_FLAG "/I")
+else()
+    set(PREPROCESS_FLAGS "-E;-P")
+    set(INCLUDE_FLAG "-I")
+endif()
+
+function(get_time_ms out)
+    string(TIMESTAMP now "%s.%f" UTC)
+    string(REGEX MATCH "^([0-9]+)\\.0*([0-9]*)$" _ "${now}")
+    set(microseconds "${CMAKE_MATCH_2}")
+
+    if(microseconds STREQUAL "")
+        set(microseconds 0)
+    endif()
+
+    math(EXPR milliseconds "${CMAKE_MATCH_1} * 1000 + ${microseconds} / 1000")
+    set(${out} ${milliseconds} PARENT_SCOPE)
+endfunction()
+
+# runs the command in the directory and stores its wall time in out, or -1 if it failed
+function(run_timed out directory)
+    get_time_ms(start)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY "${directory}" RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    get_time_ms(end)
+
+    if(NOT result EQUAL 0)
+        list(JOIN ARGN " " command)
+        message(STATUS "[build benchmark] Command failed: ${command}\n${output}")
+        set(${out} -1 PARENT_SCOPE)
+        return()
+    endif()
+
+    math(EXPR elapsed "${end} - ${start}")
+    set(${out} ${elapsed} PARENT_SCOPE)
+endfunction()
+
+# a failed run (-1) sticks
+function(keep_fastest variable value)
+    set(fastest "${${variable}}")
+
+    if(value LESS 0 OR fastest STREQUAL "-1")
+        set(${variable} -1 PARENT_SCOPE)
+    elseif(fastest STREQUAL "" OR value LESS fastest)
+        set(${variable} ${value} PARENT_SCOPE)
+    endif()
+endfunction()
+
+# the compile command of a translation unit turned into one that pre-processes source (or replacement instead of it)
+function(make_preprocess_command out source replacement)
+    set(command)
+    set(isSkippingNext OFF)
+
+    foreach(arg IN LISTS ARGN)
+        if(isSkippingNext)
+            set(isSkippingNext OFF)
+        elseif(arg MATCHES "^(-o|-MT|-MF|-MQ)$")
+            set(isSkippingNext ON)
+        elseif(arg MATCHES "^(-c|/c|-ftime-trace|/showIncludes)$" OR arg MATCHES "^[-/]Fo")
+            # dropped
+        elseif(arg MATCHES "^-MM?D$" AND NOT CXX_COMPILER_FRONTEND_VARIANT STREQUAL "MSVC")
+            # dependency file, not the MSVC runtime flag
+        elseif(arg STREQUAL source)
+            list(APPEND command "${replacement}")
+        else()
+            list(APPEND command "${arg}")
+        endif()
+    endforeach()
+
+    list(APPEND command ${PREPROCESS_FLAGS})
+    set(${out} "${command}" PARENT_SCOPE)
+endfunction()
+
+# number of lines the command writes to stdout, -1 if it failed
+function(count_output_lines out directory outputFile)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY "${directory}" RESULT_VARIABLE result OUTPUT_FILE "${outputFile}" ERROR_QUIET)
+
+    if(NOT result EQUAL 0)
+        set(${out} -1 PARENT_SCOPE)
+        return()
+    endif()
+
+    file(READ "${outputFile}" content)
+    string(REGEX REPLACE "[^\n]" "" newlines "${content}")
+    string(LENGTH "${newlines}" lines)
+
+    set(${out} ${lines} PARENT_SCOPE)
+endfunction()
+
+# the compile command of entry index of compile_commands.json as a list
+function(get_compile_command out commands index)
+    string(JSON command ERROR_VARIABLE error GET "${commands}" ${index} command)
+
+    if(NOT error)
+        separate_arguments(arguments NATIVE_COMMAND "${command}")
+        set(${out} "${arguments}" PARENT_SCOPE)
+        return()
+    endif()
+
+    set(arguments)
+    string(JSON count LENGTH "${commands}" ${index} arguments)
+    math(EXPR last "${count} - 1")
+
+    foreach(i RANGE ${last})
+        string(JSON argument GET "${commands}" ${index} arguments ${i})
+        list(APPEND arguments "${argument}")
+    endforeach()
+
+    set(${out} "${arguments}" PARENT_SCOPE)
+endfunction()
+
+# Total <phase> from a Clang -ftime-trace file, in milliseconds, -1 if missing
+function(read_time_trace out traceFile phase)
+    set(${out} -1 PARENT_SCOPE)
+
+    if(NOT EXISTS "${traceFile}")
+        return()
+    endif()
+
+    file(READ "${traceFile}" trace)
+
+    if(trace MATCHES "\"dur\":([0-9]+),\"name\":\"Total ${phase}\"")
+        math(EXPR milliseconds "${CMAKE_MATCH_1} / 1000")
+        set(${out} ${milliseconds} PARENT_SCOPE)
+    endif()
+endfunction()
+
+function(benchmark_sample sample)
+    set(source "${SOURCE_ROOT}/${sample}")
+    set(build "${WORK_DIR}/${sample}")
+
+    foreach(metric IN LISTS METRICS)
+        set(${metric} "")
+    endforeach()
+
+    set(configureArguments -S "${source}" -B "${build}" -G "${GENERATOR}" "-DCMAKE_BUILD_TYPE=${BUILD_TYPE}" "-DCMAKE_CXX_COMPILER=${CXX_COMPILER}" -DCMAKE_EXPORT_COMPILE_COMMANDS=ON)
+
+    if(MAKE_PROGRAM)
+        list(APPEND configureArguments "-DCMAKE_MAKE_PROGRAM=${MAKE_PROGRAM}")
+    endif()
+
+    # vcpkg installs into the build directory by default; keeping the packages outside of it lets the warm-up
+    # configure below install them once for all runs
+    if(TOOLCHAIN_FILE)
+        list(APPEND configureArguments "-DCMAKE_TOOLCHAIN_FILE=${TOOLCHAIN_FILE}" "-DVCPKG_INSTALLED_DIR=${WORK_DIR}/vcpkg_installed/${sample}")
+    endif()
+
+    if(USE_TIME_TRACE)
+        list(APPEND configureArguments "-DCMAKE_CXX_FLAGS=-ftime-trace")
+    endif()
+
+    set(buildCommand "${CMAKE_COMMAND}" --build "${build}" --config "${BUILD_TYPE}" --parallel)
+    set(error "")
+
+    # untimed: the first configure on a fresh WORK_DIR has vcpkg build every dependency, which configureMs must not
+    # include, or a baseline comparison would measure whether the packages were already installed
+    message(STATUS "[build benchmark] ${sample}: warm-up configure")
+    file(REMOVE_RECURSE "${build}")
+    run_timed(elapsed "${SOURCE_ROOT}" "${CMAKE_COMMAND}" ${configureArguments})
+
+    if(elapsed LESS 0)
+        set(error "configure failed")
+    endif()
+
+    foreach(run RANGE 1 ${REPEAT})
+        if(error)
+            break()
+        endif()
+
+        message(STATUS "[build benchmark] ${sample}: run ${run} of ${REPEAT}")
+
+        file(REMOVE_RECURSE "${build}")
+
+        run_timed(elapsed "${SOURCE_ROOT}" "${CMAKE_COMMAND}" ${configureArguments})
+        keep_fastest(configureMs ${elapsed})
+
+        if(elapsed LESS 0)
+            set(error "configure failed")
+            break()
+        endif()
+
+        run_timed(elapsed "${build}" ${buildCommand})
+        keep_fastest(cleanBuildMs ${elapsed})
+
+        if(elapsed LESS 0)
+            set(error "build failed")
+            break()
+        endif()
+
+        file(TOUCH_NOCREATE "${source}/src/main.cpp")
+
+        run_timed(elapsed "${build}" ${buildCommand})
+        keep_fastest(incrementalBuildMs ${elapsed})
+
+        file(GLOB_RECURSE executables LIST_DIRECTORIES false "${build}/${sample}" "${build}/${sample}.exe")
+        list(FILTER executables EXCLUDE REGEX "/CMakeFiles/")
+
+        if(executables)
+            file(REMOVE ${executables})
+
+            run_timed(elapsed "${build}" ${buildCommand})
+            keep_fastest(linkMs ${elapsed})
+        else()
+            keep_fastest(linkMs -1)
+        endif()
+    endforeach()
+
+    set(json "    \"${sample}\": {\n")
+
+    if(error)
+        message(STATUS "[build benchmark] ${sample}: ${error}")
+        string(APPEND json "      \"error\": \"${error}\"\n    }")
+        set(SAMPLE_JSON "${json}" PARENT_SCOPE)
+        return()
+    endif()
+
+    # per translation unit, from the last clean build
+    set(translationUnitsJson "")
+    set(headersJson "")
+    set(summary "")
+    set(preprocessedLines 0)
+
+    if(EXISTS "${build}/compile_commands.json")
+        file(MAKE_DIRECTORY "${WORK_DIR}/preprocessed/${sample}")
+
+        file(READ "${build}/compile_commands.json" commands)
+        string(JSON count LENGTH "${commands}")
+        math(EXPR last "${count} - 1")
+
+        set(mainCommand "")
+        set(mainDirectory "")
+        set(mainSource "")
+
+        foreach(i RANGE ${last})
+            string(JSON file GET "${commands}" ${i} file)
+            string(JSON directory GET "${commands}" ${i} directory)
+            get_compile_command(command "${commands}" ${i})
+
+            if(USE_TIME_TRACE)
+                string(JSON output GET "${commands}" ${i} output)
+                cmake_path(ABSOLUTE_PATH output BASE_DIRECTORY "${directory}")
+                cmake_path(REPLACE_EXTENSION output LAST_ONLY ".json" OUTPUT_VARIABLE traceFile)
+
+                read_time_trace(compileMs "${traceFile}" "ExecuteCompiler")
+                read_time_trace(frontendMs "${traceFile}" "Frontend")
+                read_time_trace(backendMs "${traceFile}" "Backend")
+                set(timing "\"compileMs\": ${compileMs}, \"frontendMs\": ${frontendMs}, \"backendMs\": ${backendMs}")
+            else()
+                run_timed(compileMs "${directory}" ${command})
+                set(timing "\"compileMs\": ${compileMs}")
+            endif()
+
+            get_filename_component(name "${file}" NAME_WE)
+            make_preprocess_command(preprocessCommand "${file}" "${file}" ${command})
+            count_output_lines(lines "${directory}" "${WORK_DIR}/preprocessed/${sample}/${i}_${name}.i" ${preprocessCommand})
+
+            if(lines GREATER 0)
+                math(EXPR preprocessedLines "${preprocessedLines} + ${lines}")
+            endif()
+
+            file(RELATIVE_PATH relativeFile "${SOURCE_ROOT}" "${file}")
+            file(TO_CMAKE_PATH "${relativeFile}" relativeFile)
+
+            if(translationUnitsJson)
+                string(APPEND translationUnitsJson ",\n")
+            endif()
+
+            string(APPEND translationUnitsJson "        { \"file\": \"${relativeFile}\", ${timing}, \"preprocessedLines\": ${lines} }")
+            string(APPEND summary "\n    ${relativeFile}: ${compileMs} ms, ${lines} pre-processed lines")
+
+            if(file MATCHES "/${sample}/src/main\\.cpp$")
+                set(mainCommand "${command}")
+                set(mainDirectory "${directory}")
+                set(mainSource "${file}")
+            endif()
+        endforeach()
+
+        # each heavy header on its own, with the flags of main.cpp
+        if(mainCommand)
+            get_filename_component(mainSourceDirectory "${mainSource}" DIRECTORY)
+
+            foreach(header IN LISTS HEADERS_${sample})
+                string(MAKE_C_IDENTIFIER "${header}" probeName)
+                set(probe "${WORK_DIR}/probes/${sample}/${probeName}.cpp")
+                file(WRITE "${probe}" "#include <${header}>\n")
+
+                make_preprocess_command(preprocessCommand "${mainSource}" "${probe}" ${mainCommand})
+                list(APPEND preprocessCommand "${INCLUDE_FLAG}${mainSourceDirectory}")
+                count_output_lines(lines "${mainDirectory}" "${WORK_DIR}/preprocessed/${sample}/${probeName}.i" ${preprocessCommand})
+
+                if(headersJson)
+                    string(APPEND headersJson ",\n")
+                endif()
+
+                string(APPEND headersJson "        \"${header}\": ${lines}")
+                string(APPEND summary "\n    <${header}>: ${lines} pre-processed lines")
+            endforeach()
+        endif()
+    else()
+        message(STATUS "[build benchmark] ${sample}: no compile_commands.json (multi-config generator?), skipping per translation unit numbers")
+        set(preprocessedLines -1)
+    endif()
+
+    message(STATUS "[build benchmark] ${sample}: configure ${configureMs} ms, clean build ${cleanBuildMs} ms, incremental build ${incrementalBuildMs} ms, link ${linkMs} ms, pre-processed lines ${preprocessedLines}${summary}")
+
+    foreach(metric IN LISTS METRICS)
+        string(APPEND json "      \"${metric}\": ${${metric}},\n")
+        set(${sample}_${metric} ${${metric}} PARENT_SCOPE)
+    endforeach()
+
+    string(APPEND json "      \"translationUnits\": [\n${translationUnitsJson}\n      ],\n")
+    string(APPEND json "      \"headers\": {\n${headersJson}\n      }\n    }")
+
+    set(SAMPLE_JSON "${json}" PARENT_SCOPE)
+endfunction()
+
+file(REMOVE_RECURSE "${WORK_DIR}/preprocessed" "${WORK_DIR}/probes")
+
+set(samplesJson "")
+
+foreach(sample IN LISTS SAMPLES)
+    benchmark_sample(${sample})
+
+    if(samplesJson)
+        string(APPEND samplesJson ",\n")
+    endif()
+
+    string(APPEND samplesJson "${SAMPLE_JSON}")
+endforeach()
+
+if(USE_TIME_TRACE)
+    set(timeSource "ftime-trace")
+else()
+    set(timeSource "wall")
+endif()
+
+file(WRITE "${OUTPUT}" "{
+  \"generator\": \"${GENERATOR}\",
+  \"compiler\": \"${CXX_COMPILER_ID} ${CXX_COMPILER_VERSION}\",
+  \"buildType\": \"${BUILD_TYPE}\",
+  \"compileTimeSource\": \"${timeSource}\",
+  \"samples\": {
+${samplesJson}
+  }
+}
+")
+
+message(STATUS "[build benchmark] report written to '${OUTPUT}'")
+
+# regressions against an earlier report; timings are noisy, hence the tolerance
+if(BASELINE)
+    file(READ "${BASELINE}" baseline)
+    set(regressions "")
+
+    foreach(sample IN LISTS SAMPLES)
+        foreach(metric IN LISTS METRICS)
+            set(current "${${sample}_${metric}}")
+            string(JSON previous ERROR_VARIABLE error GET "${baseline}" samples ${sample} ${metric})
+
+            if(error OR current STREQUAL "" OR current LESS 0 OR previous LESS_EQUAL 0)
+                continue()
+            endif()
+
+            math(EXPR limit "${previous} * (100 + ${TOLERANCE}) / 100")
+
+            # a few milliseconds of jitter on a short step are not a regression
+            if(metric MATCHES "Ms$")
+                math(EXPR noiseFloor "${previous} + 50")
+
+                if(limit LESS noiseFloor)
+                    set(limit ${noiseFloor})
+                endif()
+            endif()
+
+            if(current GREATER limit)
+                string(APPEND regressions "\n  ${sample} ${metric}: ${previous} -> ${current}")
+            endif()
+        endforeach()
+    endforeach()
+
+    if(regressions)
+        message(FATAL_ERROR "[build benchmark] regressions of more than ${TOLERANCE}% against '${BASELINE}':${regressions}")
+    endif()
+
+    message(STATUS "[build benchmark] no regressions against '${BASELINE}'")
+endif()
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct FrameBenchmarkOptions {
+    uint32_t frameCount = 0; // 0 disables the benchmark
+    std::string outputPath; // defaults to <sample>_benchmark.json in the working directory
+};
+
+// Picks --benchmark-frames N and --benchmark-output PATH out of the command line, ignoring everything else. Returns
+// false, after printing why, if N is not an unsigned number; samples exit then, before creating a window.
+bool parseFrameBenchmarkOptions(int argc, char** argv, FrameBenchmarkOptions& options);
+
+// Frame timing shared by all samples, so their numbers can be compared directly.
+//
+// CPU frame time is measured from beginFrame() to endFrame(): samples call these around recording and submitting a
+// frame, after waiting for a free back buffer and before presenting. The present interval is the time between two
+// markPresent() calls, made right after present returns; it is the frame time as seen on screen. Headless renderers
+// call markPresent() after submitting.
+//
+// A benchmark measures throughput, so while one runs (frameCount > 0) samples present without waiting for vertical
+// sync; otherwise the present interval would only show the display's refresh rate.
+class FrameBenchmark {
+public:
+    FrameBenchmark(std::string sampleName, std::string apiName, FrameBenchmarkOptions options);
+
+    // extra fields for the JSON output and the summary line, e.g. the number of frames in flight
+    void setMetadata(const std::string& key, const std::string& value);
+    void setMetadata(const std::string& key, double value);
+
+    void beginFrame();
+    void endFrame();
+    void markPresent();
+
+    bool isFinished() const;
+
+    // prints the summary line and writes the JSON file; returns false if the file could not be written
+    bool writeResults() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string sampleName;
+    std::string apiName;
+    FrameBenchmarkOptions options;
+
+    // values are stored as JSON already
+    std::vector<std::pair<std::string, std::string>> metadata;
+
+    std::vector<double> cpuFrameTimes;
+    std::vector<double> presentIntervals;
+
+    Clock::time_point frameStart;
+    Clock::time_point firstPresent;
+    Clock::time_point lastPresent;
+    uint32_t presentCount = 0;
+};
@@ -0,0 +1,186 @@
+#include "frame_benchmark.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+struct FrameStatistics {
+    double average = 0.0;
+    double min = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// nearest-rank percentile of sorted values
+static double percentile(const std::vector<double>& sorted, double p) {
+    auto rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static FrameStatistics computeStatistics(std::vector<double> values) {
+    FrameStatistics statistics;
+
+    if (values.empty()) {
+        return statistics;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    statistics.average = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    statistics.min = values.front();
+    statistics.p50 = percentile(values, 50.0);
+    statistics.p95 = percentile(values, 95.0);
+    statistics.p99 = percentile(values, 99.0);
+    statistics.max = values.back();
+
+    return statistics;
+}
+
+static std::string toJsonString(const std::string& value) {
+    std::string result = "\"";
+
+    for (char c : value) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default: result += c; break;
+        }
+    }
+
+    return result + "\"";
+}
+
+static void writeStatistics(std::ostream& out, const char* name, const FrameStatistics& statistics) {
+    out << "  \"" << name << "\": { "
+        << "\"avg\": " << statistics.average
+        << ", \"min\": " << statistics.min
+        << ", \"p50\": " << statistics.p50
+        << ", \"p95\": " << statistics.p95
+        << ", \"p99\": " << statistics.p99
+        << ", \"max\": " << statistics.max << " }";
+}
+
+bool parseFrameBenchmarkOptions(int argc, char** argv, FrameBenchmarkOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--benchmark-frames" && i + 1 < argc) {
+            const char* text = argv[++i];
+            const char* end = text + std::char_traits<char>::length(text);
+            auto [next, error] = std::from_chars(text, end, options.frameCount);
+
+            // "abc", "-1" and values past uint32_t
+            if (error != std::errc() || next != end) {
+                std::cerr << "Invalid value '" << text << "' for --benchmark-frames" << std::endl;
+                return false;
+            }
+        } else if (arg == "--benchmark-output" && i + 1 < argc) {
+            options.outputPath = argv[++i];
+        }
+    }
+
+    return true;
+}
+
+FrameBenchmark::FrameBenchmark(std::string sampleName, std::string apiName, FrameBenchmarkOptions options) :
+    sampleName(std::move(sampleName)),
+    apiName(std::move(apiName)),
+    options(std::move(options)) {
+    if (this->options.outputPath.empty()) {
+        this->options.outputPath = this->sampleName + "_benchmark.json";
+    }
+
+    cpuFrameTimes.reserve(this->options.frameCount);
+    presentIntervals.reserve(this->options.frameCount);
+}
+
+void FrameBenchmark::setMetadata(const std::string& key, const std::string& value) {
+    metadata.emplace_back(key, toJsonString(value));
+}
+
+void FrameBenchmark::setMetadata(const std::string& key, double value) {
+    std::ostringstream out;
+    out << value;
+
+    metadata.emplace_back(key, out.str());
+}
+
+void FrameBenchmark::beginFrame() {
+    frameStart = Clock::now();
+}
+
+void FrameBenchmark::endFrame() {
+    cpuFrameTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+}
+
+void FrameBenchmark::markPresent() {
+    auto now = Clock::now();
+
+    if (presentCount == 0) {
+        firstPresent = now;
+    } else {
+        presentIntervals.push_back(std::chrono::duration<double, std::milli>(now - lastPresent).count());
+    }
+
+    lastPresent = now;
+    presentCount++;
+}
+
+bool FrameBenchmark::isFinished() const {
+    return options.frameCount > 0 && presentCount >= options.frameCount;
+}
+
+bool FrameBenchmark::writeResults() const {
+    FrameStatistics cpuFrame = computeStatistics(cpuFrameTimes);
+    FrameStatistics presentInterval = computeStatistics(presentIntervals);
+
+    double totalMs = std::chrono::duration<double, std::milli>(lastPresent - firstPresent).count();
+    double fps = totalMs > 0.0 ? presentIntervals.size() * 1000.0 / totalMs : 0.0;
+
+    std::cout << "[benchmark] " << sampleName << " (" << apiName << ")";
+
+    for (const auto& [key, value] : metadata) {
+        std::cout << ", " << key << ": " << value;
+    }
+
+    std::cout << ", frames: " << presentCount
+              << ", total: " << totalMs << " ms"
+              << ", cpu p50/p95/p99: " << cpuFrame.p50 << "/" << cpuFrame.p95 << "/" << cpuFrame.p99 << " ms"
+              << ", present p50/p95/p99: " << presentInterval.p50 << "/" << presentInterval.p95 << "/" << presentInterval.p99 << " ms"
+              << ", fps: " << fps << std::endl;
+
+    std::ofstream out(options.outputPath, std::ios::trunc);
+
+    if (!out.is_open()) {
+        std::cerr << "[benchmark] Failed to open '" << options.outputPath << "' for writing" << std::endl;
+        return false;
+    }
+
+    out << "{\n";
+    out << "  \"sample\": " << toJsonString(sampleName) << ",\n";
+    out << "  \"api\": " << toJsonString(apiName) << ",\n";
+
+    for (const auto& [key, value] : metadata) {
+        out << "  " << toJsonString(key) << ": " << value << ",\n";
+    }
+
+    out << "  \"frames\": " << presentCount << ",\n";
+    out << "  \"totalMs\": " << totalMs << ",\n";
+    out << "  \"fps\": " << fps << ",\n";
+    writeStatistics(out, "cpuFrameMs", cpuFrame);
+    out << ",\n";
+    writeStatistics(out, "presentIntervalMs", presentInterval);
+    out << "\n}\n";
+
+    std::cout << "[benchmark] results written to '" << options.outputPath << "'" << std::endl;
+
+    return true;
+}
@@ -8,6 +8,10 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <memory>
+#include <stdlib.h>
+
+#include <frame_benchmark.h>
 // #include "tinygltf/tiny_gltf.h"
 
 using Microsoft::WRL::ComPtr;
@@ -47,6 +51,8 @@ ComPtr<ID3D12Resource> constantBuffer;
 UINT8* constantBufferData;
 ComPtr<ID3D12Resource> textureBuffer;
 ComPtr<ID3D12DescriptorHeap> srvHeap;
+std::unique_ptr<FrameBenchmark> frameBenchmark;
+UINT syncInterval = 1;
 
 // Forward declarations
 void InitD3D(HWND hwnd);
@@ -67,6 +73,12 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    FrameBenchmarkOptions benchmarkOptions;
+
+    if (!parseFrameBenchmarkOptions(__argc, __argv, benchmarkOptions)) {
+        return 1;
+    }
+
     WNDCLASSEX wc = {};
     wc.cbSize = sizeof(WNDCLASSEX);
     wc.lpfnWndProc = WindowProc;
@@ -84,6 +96,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // LoadGLTFModel("model.gltf");
     CreatePipelineState();
 
+    frameBenchmark = std::make_unique<FrameBenchmark>("directx12", "Direct3D 12", benchmarkOptions);
+
+    // Present() returns without waiting for a vertical blank while benchmarking
+    syncInterval = benchmarkOptions.frameCount > 0 ? 0 : 1;
+
     ShowWindow(hwnd, nCmdShow);
 
     MSG msg = {};
@@ -93,9 +110,17 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
             DispatchMessage(&msg);
         } else {
             Render();
+
+            if (frameBenchmark->isFinished()) {
+                DestroyWindow(hwnd);
+            }
         }
     }
 
+    if (benchmarkOptions.frameCount > 0) {
+        frameBenchmark->writeResults();
+    }
+
     WaitForGpu();
     CleanupD3D();
     return 0;
@@ -414,6 +439,8 @@ void CreatePipelineState() {
 }
 
 void Render() {
+    frameBenchmark->beginFrame();
+
     // Reset command allocator and command list
     commandAllocator->Reset();
     commandList->Reset(commandAllocator.Get(), pipelineState.Get());
@@ -485,8 +512,12 @@ void Render() {
     ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
     commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
+    frameBenchmark->endFrame();
+
     // Present the frame
-    swapChain->Present(1, 0);
+    swapChain->Present(syncInterval, 0);
+
+    frameBenchmark->markPresent();
 
     // Wait for GPU to finish
     WaitForGpu();
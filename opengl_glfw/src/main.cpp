@@ -5,13 +5,21 @@
 
 #include <iostream>
 
+#include <frame_benchmark.h>
+
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    FrameBenchmarkOptions benchmarkOptions;
+
+    if (!parseFrameBenchmarkOptions(argc, argv, benchmarkOptions)) {
+        return 1;
+    }
+
     if (!glfwInit()) {
         std::cerr << "Could not load GLTF" << std::endl;
         return 1;
@@ -41,10 +49,13 @@ int main() {
         return 1;
     }
 
-    glfwSwapInterval(1);
+    // no vsync while benchmarking
+    glfwSwapInterval(benchmarkOptions.frameCount > 0 ? 0 : 1);
 
     glfwSetKeyCallback(window, key_callback);
 
+    FrameBenchmark benchmark("opengl_glfw", "OpenGL", benchmarkOptions);
+
     bool isRunning = true;
 
     while (isRunning) {
@@ -52,7 +63,7 @@ int main() {
             isRunning = false;
         }
 
-        double time = glfwGetTime();
+        benchmark.beginFrame();
 
         int framebufferWidth, framebufferHeight;
         glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
@@ -60,8 +71,21 @@ int main() {
         glViewport(0, 0, framebufferWidth, framebufferHeight);
         glClear(GL_COLOR_BUFFER_BIT);
 
+        benchmark.endFrame();
+
         glfwSwapBuffers(window);
+
+        benchmark.markPresent();
+
         glfwPollEvents();
+
+        if (benchmark.isFinished()) {
+            isRunning = false;
+        }
+    }
+
+    if (benchmarkOptions.frameCount > 0) {
+        benchmark.writeResults();
     }
 
     glfwDestroyWindow(window);
@@ -3,7 +3,15 @@
 #include <SDL3/SDL_opengl.h>
 #include <iostream>
 
-int main() {
+#include <frame_benchmark.h>
+
+int main(int argc, char** argv) {
+    FrameBenchmarkOptions benchmarkOptions;
+
+    if (!parseFrameBenchmarkOptions(argc, argv, benchmarkOptions)) {
+        return 1;
+    }
+
     const auto windowWidth = 1024;
     const auto windowHeight = 768;
 
@@ -29,7 +37,6 @@ int main() {
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetSwapInterval(1);
 
     SDL_GLContext context = SDL_GL_CreateContext(window);
 
@@ -38,6 +45,9 @@ int main() {
         return 1;
     }
 
+    // needs a current context; no vsync while benchmarking
+    SDL_GL_SetSwapInterval(benchmarkOptions.frameCount > 0 ? 0 : 1);
+
     std::cout << "Load GLAD..." << std::endl;
 
     if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
@@ -45,6 +55,8 @@ int main() {
         return 1;
     }
 
+    FrameBenchmark benchmark("opengl_sdl3", "OpenGL", benchmarkOptions);
+
     bool isRunning = true;
 
     while (isRunning) {
@@ -56,10 +68,24 @@ int main() {
             }
         }
 
+        benchmark.beginFrame();
+
         glViewport(0, 0, windowWidth, windowHeight);
         glClear(GL_COLOR_BUFFER_BIT);
 
+        benchmark.endFrame();
+
         SDL_GL_SwapWindow(window);
+
+        benchmark.markPresent();
+
+        if (benchmark.isFinished()) {
+            isRunning = false;
+        }
+    }
+
+    if (benchmarkOptions.frameCount > 0) {
+        benchmark.writeResults();
     }
 
     return 0;
@@ -0,0 +1,48 @@
+# Generates a C++ source that defines getEmbeddedShaders() (src/embedded_shaders.h) from compiled SPIR-V.
+#
+# Usage: cmake -DSPIRV_FILES=a.spv,b.spv -DOUTPUT=embedded_shaders.cpp -P embed_spirv.cmake
+
+string(REPLACE "," ";" SPIRV_FILES "${SPIRV_FILES}")
+
+set(ARRAYS "")
+set(TABLE "")
+set(INDEX 0)
+
+foreach(SPIRV_FILE ${SPIRV_FILES})
+    get_filename_component(SHADER_FILE_NAME ${SPIRV_FILE} NAME)
+
+    file(READ ${SPIRV_FILE} HEX_CONTENTS HEX)
+    string(LENGTH "${HEX_CONTENTS}" HEX_LENGTH)
+    math(EXPR WORD_REMAINDER "${HEX_LENGTH} % 8")
+
+    if(HEX_LENGTH EQUAL 0 OR NOT WORD_REMAINDER EQUAL 0)
+        message(FATAL_ERROR "${SPIRV_FILE} is not SPIR-V: its size is not a multiple of 4 bytes")
+    endif()
+
+    # the words are stored little endian, so each word's bytes are reversed, eight words per line
+    string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1, " WORDS "${HEX_CONTENTS}")
+    string(REGEX REPLACE "((0x........, ){8})" "\\1\n" WORDS "${WORDS}")
+    string(REGEX REPLACE ", \n" ",\n    " WORDS "${WORDS}")
+    string(REGEX REPLACE "[ ,\n]+$" "" WORDS "${WORDS}")
+
+    string(SUBSTRING "${WORDS}" 0 10 MAGIC)
+
+    if(NOT MAGIC STREQUAL "0x07230203")
+        message(FATAL_ERROR "${SPIRV_FILE} is not SPIR-V: it does not start with the magic number")
+    endif()
+
+    string(APPEND ARRAYS "// ${SHADER_FILE_NAME}\nstatic constexpr uint32_t SHADER_${INDEX}[] = {\n    ${WORDS}\n};\n\n")
+    string(APPEND TABLE "    { \"${SHADER_FILE_NAME}\", SHADER_${INDEX} },\n")
+
+    math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+set(CONTENTS "// generated by cmake/embed_spirv.cmake from the compiled shaders, do not edit\n\n")
+string(APPEND CONTENTS "#include \"embedded_shaders.h\"\n\n")
+string(APPEND CONTENTS "${ARRAYS}")
+string(APPEND CONTENTS "static constexpr EmbeddedShader EMBEDDED_SHADERS[] = {\n${TABLE}};\n\n")
+string(APPEND CONTENTS "std::span<const EmbeddedShader> getEmbeddedShaders() {\n    return EMBEDDED_SHADERS;\n}\n")
+
+# only touch the output when it changes, so an unchanged shader set does not recompile it; the build tracks the step
+# with a stamp file instead
+file(CONFIGURE OUTPUT ${OUTPUT} CONTENT "${CONTENTS}" @ONLY)
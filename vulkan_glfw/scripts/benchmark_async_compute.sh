@@ -0,0 +1,35 @@
+#!/usr/bin/env sh
+# Frame time of the particle scene with the simulation on the async compute queue and inline on the graphics queue,
+# rendering headless. Uses the system's Vulkan driver: lavapipe has no compute-only queue family, so both runs would
+# be the same.
+#
+# Usage: scripts/benchmark_async_compute.sh [path/to/vulkan_glfw] [frame count] [particle count] [extra arguments...]
+#
+# Each run writes its results to async_compute_Q.json next to the executable (Q = async or graphics); compare the
+# [particles] lines for the wall-clock time per frame.
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+FRAMES="${2:-1000}"
+PARTICLES="${3:-1000000}"
+
+if [ $# -ge 3 ]; then
+    shift 3
+else
+    shift $#
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for Q in async graphics; do
+    if [ "$Q" = graphics ]; then
+        QUEUE_ARGUMENT="--no-async-compute"
+    else
+        QUEUE_ARGUMENT=""
+    fi
+
+    "./$(basename "$EXECUTABLE")" --headless $QUEUE_ARGUMENT --particles "$PARTICLES" --benchmark-frames "$FRAMES" \
+        --benchmark-output "async_compute_$Q.json" "$@" | grep '^\[benchmark\]\|^\[particles\]'
+done
@@ -0,0 +1,43 @@
+#!/usr/bin/env sh
+# Render pass against dynamic rendering: the same headless scene recorded through a VkRenderPass and VkFramebuffers,
+# then with vkCmdBeginRendering and synchronization2 barriers, on lavapipe (Mesa's CPU Vulkan driver).
+#
+# Usage: scripts/benchmark_dynamic_rendering.sh [path/to/vulkan_glfw] [frame count] [draws per frame] [extra arguments...]
+#
+# Each run writes its results to rendering_path_P.json next to the executable (P = render_pass or dynamic_rendering);
+# compare the frame times for the per-frame overhead and the [render targets] lines for the setup cost.
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+FRAMES="${2:-1000}"
+DRAWS="${3:-1}"
+
+if [ $# -ge 3 ]; then
+    shift 3
+else
+    shift $#
+fi
+
+# lavapipe ICD manifest; override with LAVAPIPE_ICD when it lives somewhere else
+LAVAPIPE_ICD="${LAVAPIPE_ICD:-/usr/share/vulkan/icd.d/lvp_icd.x86_64.json}"
+
+if [ ! -f "$LAVAPIPE_ICD" ]; then
+    echo "Could not find lavapipe ICD at '$LAVAPIPE_ICD'" >&2
+    exit 1
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for P in render_pass dynamic_rendering; do
+    if [ "$P" = dynamic_rendering ]; then
+        PATH_ARGUMENT="--dynamic-rendering"
+    else
+        PATH_ARGUMENT=""
+    fi
+
+    VK_DRIVER_FILES="$LAVAPIPE_ICD" VK_ICD_FILENAMES="$LAVAPIPE_ICD" \
+        "./$(basename "$EXECUTABLE")" --headless $PATH_ARGUMENT --draws "$DRAWS" --benchmark-frames "$FRAMES" \
+        --benchmark-output "rendering_path_$P.json" "$@" | grep '^\[benchmark\]\|^\[render targets\]'
+done
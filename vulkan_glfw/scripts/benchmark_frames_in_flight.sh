@@ -0,0 +1,35 @@
+#!/usr/bin/env sh
+# Runs the frame-time benchmark with 1, 2 and 3 frames in flight on lavapipe (Mesa's CPU Vulkan driver).
+#
+# Usage: scripts/benchmark_frames_in_flight.sh [path/to/vulkan_glfw] [frame count] [extra arguments...]
+#
+# Extra arguments are passed on to every run, e.g. --headless on machines without a display.
+# Each run writes its results to frames_in_flight_N.json next to the executable.
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+FRAMES="${2:-2000}"
+
+if [ $# -ge 2 ]; then
+    shift 2
+else
+    shift $#
+fi
+
+# lavapipe ICD manifest; override with LAVAPIPE_ICD when it lives somewhere else
+LAVAPIPE_ICD="${LAVAPIPE_ICD:-/usr/share/vulkan/icd.d/lvp_icd.x86_64.json}"
+
+if [ ! -f "$LAVAPIPE_ICD" ]; then
+    echo "Could not find lavapipe ICD at '$LAVAPIPE_ICD'" >&2
+    exit 1
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for N in 1 2 3; do
+    VK_DRIVER_FILES="$LAVAPIPE_ICD" VK_ICD_FILENAMES="$LAVAPIPE_ICD" \
+        "./$(basename "$EXECUTABLE")" --frames-in-flight "$N" --benchmark-frames "$FRAMES" \
+        --benchmark-output "frames_in_flight_$N.json" "$@" | grep '^\[benchmark\]'
+done
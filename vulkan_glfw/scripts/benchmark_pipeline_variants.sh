@@ -0,0 +1,44 @@
+#!/usr/bin/env sh
+# Time until all pipeline variants are ready, linked from graphics pipeline libraries and compiled as complete
+# pipelines, on lavapipe (Mesa's CPU Vulkan driver).
+#
+# Usage: scripts/benchmark_pipeline_variants.sh [path/to/vulkan_glfw] [variant count] [extra arguments...]
+#
+# Every run renders headless without the pipeline cache, so each variant is compiled from SPIR-V, and draws each variant
+# once per frame. Pass e.g. --variant-threads 1 to see how much of the difference is the worker pool.
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+VARIANTS="${2:-96}"
+
+if [ $# -ge 2 ]; then
+    shift 2
+else
+    shift $#
+fi
+
+# lavapipe ICD manifest; override with LAVAPIPE_ICD when it lives somewhere else
+LAVAPIPE_ICD="${LAVAPIPE_ICD:-/usr/share/vulkan/icd.d/lvp_icd.x86_64.json}"
+
+if [ ! -f "$LAVAPIPE_ICD" ]; then
+    echo "Could not find lavapipe ICD at '$LAVAPIPE_ICD'" >&2
+    exit 1
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for M in library complete; do
+    if [ "$M" = complete ]; then
+        LIBRARY_ARGUMENT="--no-pipeline-library"
+    else
+        LIBRARY_ARGUMENT=""
+    fi
+
+    echo "$M:"
+
+    VK_DRIVER_FILES="$LAVAPIPE_ICD" VK_ICD_FILENAMES="$LAVAPIPE_ICD" \
+        "./$(basename "$EXECUTABLE")" --headless --no-pipeline-cache --pipeline-variants "$VARIANTS" --draws "$VARIANTS" \
+        --benchmark-frames 600 --benchmark-output "pipeline_variants_$M.json" $LIBRARY_ARGUMENT "$@" | grep '^Compiling\|^\[variants\]'
+done
@@ -0,0 +1,37 @@
+#!/usr/bin/env sh
+# Draw-count scaling of command recording: inline into the primary command buffer, then on 1, 2, 4, 8 and 16 threads
+# recording secondary command buffers, on lavapipe (Mesa's CPU Vulkan driver).
+#
+# Usage: scripts/benchmark_record_threads.sh [path/to/vulkan_glfw] [frame count] [draws per frame] [extra arguments...]
+#
+# Runs headless by default. Each run writes its results to record_threads_N.json next to the executable
+# (N = 0 for inline recording); compare the cpu frame times, which is where recording shows up.
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+FRAMES="${2:-500}"
+DRAWS="${3:-50000}"
+
+if [ $# -ge 3 ]; then
+    shift 3
+else
+    shift $#
+fi
+
+# lavapipe ICD manifest; override with LAVAPIPE_ICD when it lives somewhere else
+LAVAPIPE_ICD="${LAVAPIPE_ICD:-/usr/share/vulkan/icd.d/lvp_icd.x86_64.json}"
+
+if [ ! -f "$LAVAPIPE_ICD" ]; then
+    echo "Could not find lavapipe ICD at '$LAVAPIPE_ICD'" >&2
+    exit 1
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for N in 0 1 2 4 8 16; do
+    VK_DRIVER_FILES="$LAVAPIPE_ICD" VK_ICD_FILENAMES="$LAVAPIPE_ICD" \
+        "./$(basename "$EXECUTABLE")" --headless --record-threads "$N" --draws "$DRAWS" --benchmark-frames "$FRAMES" \
+        --benchmark-output "record_threads_$N.json" "$@" | grep '^\[benchmark\]'
+done
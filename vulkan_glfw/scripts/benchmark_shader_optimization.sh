@@ -0,0 +1,43 @@
+#!/usr/bin/env sh
+# SPIR-V size and cold pipeline creation time of the optimized and the unoptimized shaders, on lavapipe (Mesa's CPU
+# Vulkan driver).
+#
+# Usage: scripts/benchmark_shader_optimization.sh [path/to/vulkan_glfw] [extra arguments...]
+#
+# Every run renders a single frame headless without the pipeline cache, so each pipeline is compiled from SPIR-V.
+# Pass e.g. --instances 1 --bindless to compare the other pipelines too.
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+
+if [ $# -ge 1 ]; then
+    shift 1
+fi
+
+# lavapipe ICD manifest; override with LAVAPIPE_ICD when it lives somewhere else
+LAVAPIPE_ICD="${LAVAPIPE_ICD:-/usr/share/vulkan/icd.d/lvp_icd.x86_64.json}"
+
+if [ ! -f "$LAVAPIPE_ICD" ]; then
+    echo "Could not find lavapipe ICD at '$LAVAPIPE_ICD'" >&2
+    exit 1
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for S in optimized unoptimized; do
+    if [ "$S" = unoptimized ]; then
+        SHADER_ARGUMENT="--unoptimized-shaders"
+        SHADER_DIRECTORY="shaders/unoptimized"
+    else
+        SHADER_ARGUMENT=""
+        SHADER_DIRECTORY="shaders"
+    fi
+
+    echo "$S: $(cat "$SHADER_DIRECTORY"/*.spv | wc -c) bytes of SPIR-V in total"
+
+    VK_DRIVER_FILES="$LAVAPIPE_ICD" VK_ICD_FILENAMES="$LAVAPIPE_ICD" \
+        "./$(basename "$EXECUTABLE")" --headless --no-pipeline-cache $SHADER_ARGUMENT --benchmark-frames 1 \
+        --benchmark-output "shader_optimization_$S.json" "$@" | grep '^\[shaders\]\|^\[pipeline cache\]\|^\[startup\] pipelines'
+done
@@ -0,0 +1,48 @@
+#!/usr/bin/env sh
+# Launch-to-first-present latency on lavapipe (Mesa's CPU Vulkan driver), cold and warm, with and without --fast-start.
+#
+# Usage: scripts/benchmark_startup.sh [path/to/vulkan_glfw] [warm run count] [extra arguments...]
+#
+# Every run renders a single frame headless. The cold run of each mode deletes pipeline_cache.bin first, the warm runs
+# after it start from the cache the previous run saved. Each run writes its results, with startupMs, to
+# startup_M_R.json next to the executable (M = normal or fast, R = cold or the warm run's number).
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+RUNS="${2:-3}"
+
+if [ $# -ge 2 ]; then
+    shift 2
+else
+    shift $#
+fi
+
+# lavapipe ICD manifest; override with LAVAPIPE_ICD when it lives somewhere else
+LAVAPIPE_ICD="${LAVAPIPE_ICD:-/usr/share/vulkan/icd.d/lvp_icd.x86_64.json}"
+
+if [ ! -f "$LAVAPIPE_ICD" ]; then
+    echo "Could not find lavapipe ICD at '$LAVAPIPE_ICD'" >&2
+    exit 1
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for M in normal fast; do
+    if [ "$M" = fast ]; then
+        MODE_ARGUMENT="--fast-start"
+    else
+        MODE_ARGUMENT=""
+    fi
+
+    rm -f pipeline_cache.bin
+
+    for R in cold $(seq 1 "$RUNS"); do
+        echo "$M, $R:"
+
+        VK_DRIVER_FILES="$LAVAPIPE_ICD" VK_ICD_FILENAMES="$LAVAPIPE_ICD" \
+            "./$(basename "$EXECUTABLE")" --headless $MODE_ARGUMENT --benchmark-frames 1 \
+            --benchmark-output "startup_${M}_$R.json" "$@" | grep '^\[startup\]'
+    done
+done
@@ -0,0 +1,34 @@
+#!/usr/bin/env sh
+# Upload bandwidth with the staging copies on the dedicated transfer queue and on the graphics queue, while rendering
+# headless. Uses the system's Vulkan driver: lavapipe has no transfer-only queue family, so both runs would be the same.
+#
+# Usage: scripts/benchmark_transfer_queue.sh [path/to/vulkan_glfw] [frame count] [MiB uploaded per frame] [extra arguments...]
+#
+# Each run writes its results to upload_queue_Q.json next to the executable (Q = transfer or graphics); compare the
+# [uploads] lines for the bandwidth and the frame times for what the copies cost the rendering.
+
+set -e
+
+EXECUTABLE="${1:-build/vulkan_glfw}"
+FRAMES="${2:-1000}"
+MEGABYTES="${3:-16}"
+
+if [ $# -ge 3 ]; then
+    shift 3
+else
+    shift $#
+fi
+
+# shaders are loaded relative to the working directory
+cd "$(dirname "$EXECUTABLE")"
+
+for Q in transfer graphics; do
+    if [ "$Q" = graphics ]; then
+        QUEUE_ARGUMENT="--no-transfer-queue"
+    else
+        QUEUE_ARGUMENT=""
+    fi
+
+    "./$(basename "$EXECUTABLE")" --headless $QUEUE_ARGUMENT --upload-stress "$MEGABYTES" --benchmark-frames "$FRAMES" \
+        --benchmark-output "upload_queue_$Q.json" "$@" | grep '^\[benchmark\]\|^\[uploads\]'
+done
@@ -0,0 +1,24 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(std430, set = 1, binding = 1) readonly buffer Material {
+    vec4 color;
+} materials[];
+
+// the tint in front of the indices belongs to the vertex shader
+layout(push_constant) uniform PushConstants {
+    layout(offset = 16) uint textureIndex;
+    uint materialIndex;
+};
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec3 texel = texture(textures[textureIndex], fragTexCoord).rgb;
+    outColor = vec4(fragColor * texel * materials[materialIndex].color.rgb, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// per instance
+layout(location = 2) in vec4 inTransform; // xy offset, zw scale
+layout(location = 3) in vec4 inInstanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = vec4(inTransform.xy + inPosition * inTransform.zw, 0.0, 1.0);
+    fragColor = inColor * inInstanceColor.rgb;
+}
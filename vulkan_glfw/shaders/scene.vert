@@ -0,0 +1,20 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// per instance: xy center, z scale, w bounding sphere radius
+layout(location = 2) in vec4 inObject;
+
+// xy position, z zoom
+layout(push_constant) uniform PushConstants {
+    vec4 camera;
+};
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    vec2 position = inObject.xy + inPosition * inObject.z;
+    gl_Position = vec4((position - camera.xy) * camera.z, 0.0, 1.0);
+    fragColor = inColor;
+}
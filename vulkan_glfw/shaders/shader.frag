@@ -1,9 +1,24 @@
 #version 450
 
+// set per pipeline variant (src/pipeline_variants.h); the defaults shade the plain vertex color
+// 0: as is, 1: channels swapped, 2: grayscale, 3: inverted
+layout(constant_id = 0) const uint COLOR_MODE = 0;
+layout(constant_id = 1) const float ALPHA = 1.0;
+
 layout(location = 0) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    vec3 color = fragColor;
+
+    if (COLOR_MODE == 1) {
+        color = color.bgr;
+    } else if (COLOR_MODE == 2) {
+        color = vec3(dot(color, vec3(0.299, 0.587, 0.114)));
+    } else if (COLOR_MODE == 3) {
+        color = 1.0 - color;
+    }
+
+    outColor = vec4(color, ALPHA);
 }
@@ -3,9 +3,20 @@
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
 
+// per draw, at a dynamic offset in the uniform ring
+layout(set = 0, binding = 0) uniform DrawUniforms {
+    mat4 transform;
+};
+
+layout(push_constant) uniform PushConstants {
+    vec4 tint;
+};
+
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    gl_Position = transform * vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor * tint.rgb;
+    fragTexCoord = inPosition + 0.5;
 }
@@ -0,0 +1,78 @@
+#include "async_log.h"
+
+AsyncLog::AsyncLog(std::ostream& stream) :
+    stream(stream) {
+    stream.flush();
+
+    target = stream.rdbuf(this);
+    worker = std::thread(&AsyncLog::run, this);
+}
+
+AsyncLog::~AsyncLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+
+    condition.notify_one();
+    worker.join();
+
+    stream.rdbuf(target);
+}
+
+AsyncLog::int_type AsyncLog::overflow(int_type character) {
+    if (traits_type::eq_int_type(character, traits_type::eof())) {
+        return traits_type::not_eof(character);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(traits_type::to_char_type(character));
+
+    return character;
+}
+
+std::streamsize AsyncLog::xsputn(const char* data, std::streamsize count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.append(data, static_cast<size_t>(count));
+
+    return count;
+}
+
+int AsyncLog::sync() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isFlushRequested = true;
+    }
+
+    condition.notify_one();
+
+    return 0;
+}
+
+void AsyncLog::run() {
+    std::string text;
+
+    while (true) {
+        bool isDone;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return isFlushRequested || isStopping; });
+
+            // swapping keeps both strings' capacity, so steady logging allocates nothing
+            text.swap(pending);
+            isFlushRequested = false;
+            isDone = isStopping;
+        }
+
+        if (!text.empty()) {
+            target->sputn(text.data(), static_cast<std::streamsize>(text.size()));
+            target->pubsync();
+            text.clear();
+        }
+
+        if (isDone) {
+            return;
+        }
+    }
+}
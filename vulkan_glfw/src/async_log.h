@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+// Takes over the stream buffer of an output stream (std::cout) and has a worker thread write the text to the original
+// buffer. A flush, which std::endl does after every line, only wakes the worker, so the logging thread never waits for
+// the terminal. Streams that are not taken over, like std::cerr, stay synchronous, so errors may appear ahead of
+// earlier log lines.
+//
+// Everything logged is written and the original buffer restored on destruction.
+class AsyncLog : private std::streambuf {
+public:
+    explicit AsyncLog(std::ostream& stream);
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+private:
+    int_type overflow(int_type character) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+    int sync() override;
+
+    void run();
+
+    std::ostream& stream;
+    std::streambuf* target;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    // written by any thread that logs, taken whole by the worker
+    std::string pending;
+    bool isFlushRequested = false;
+    bool isStopping = false;
+
+    std::thread worker;
+};
@@ -0,0 +1,253 @@
+#include "bindless_descriptors.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+bool BindlessDescriptors::isSupported(VkInstance instance, VkPhysicalDevice physicalDevice, uint32_t textureCapacity, uint32_t bufferCapacity) {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const char* requiredExtension : getRequiredExtensions()) {
+        bool isFound = false;
+
+        for (const auto& extension : availableExtensions) {
+            if (std::strcmp(extension.extensionName, requiredExtension) == 0) {
+                isFound = true;
+                break;
+            }
+        }
+
+        if (!isFound) {
+            return false;
+        }
+    }
+
+    auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+    auto getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
+
+    if (getFeatures2 == nullptr || getProperties2 == nullptr) {
+        return false;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2KHR features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &indexingFeatures;
+
+    getFeatures2(physicalDevice, &features);
+
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2KHR properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+    properties.pNext = &indexingProperties;
+
+    getProperties2(physicalDevice, &properties);
+
+    // the shaders index both arrays with values from push constants, which needs the core dynamic indexing features
+    return features.features.shaderSampledImageArrayDynamicIndexing
+        && features.features.shaderStorageBufferArrayDynamicIndexing
+        && indexingFeatures.runtimeDescriptorArray
+        && indexingFeatures.descriptorBindingPartiallyBound
+        && indexingFeatures.descriptorBindingUpdateUnusedWhilePending
+        && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+        && indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind
+        && textureCapacity <= indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages
+        && textureCapacity <= indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers
+        && textureCapacity <= indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages
+        && textureCapacity <= indexingProperties.maxDescriptorSetUpdateAfterBindSamplers
+        && bufferCapacity <= indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+        && bufferCapacity <= indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers
+        && textureCapacity + bufferCapacity <= indexingProperties.maxPerStageUpdateAfterBindResources;
+}
+
+const std::vector<const char*>& BindlessDescriptors::getRequiredExtensions() {
+    // descriptor indexing depends on maintenance3
+    static const std::vector<const char*> extensions = {
+        VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+        VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
+    };
+
+    return extensions;
+}
+
+VkPhysicalDeviceDescriptorIndexingFeaturesEXT BindlessDescriptors::getRequiredFeatures() {
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    features.runtimeDescriptorArray = VK_TRUE;
+    features.descriptorBindingPartiallyBound = VK_TRUE;
+    features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+
+    return features;
+}
+
+void BindlessDescriptors::enableRequiredCoreFeatures(VkPhysicalDeviceFeatures& features) {
+    // the texture and material indices come from push constants
+    features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+    features.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+}
+
+BindlessDescriptors::BindlessDescriptors(VkDevice device, VkShaderStageFlags stages, uint32_t textureCapacity, uint32_t bufferCapacity, uint32_t framesInFlight) :
+    device(device),
+    framesInFlight(framesInFlight) {
+    textureIndices.capacity = textureCapacity;
+    bufferIndices.capacity = bufferCapacity;
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+
+    bindings[0].binding = TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = textureCapacity;
+    bindings[0].stageFlags = stages;
+
+    bindings[1].binding = BUFFER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = bufferCapacity;
+    bindings[1].stageFlags = stages;
+
+    layoutBindings.assign(bindings.begin(), bindings.end());
+
+    // elements that were never written must not be accessed, everything else may be written at any time
+    VkDescriptorBindingFlagsEXT bindingFlag = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+    std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags = { bindingFlag, bindingFlag };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor set layout!");
+    }
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {{
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCapacity },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, bufferCapacity }
+    }};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bindless descriptor set!");
+    }
+}
+
+BindlessDescriptors::~BindlessDescriptors() {
+    // destroying the pool frees the set
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+uint32_t BindlessDescriptors::IndexAllocator::allocate() {
+    if (!freeIndices.empty()) {
+        uint32_t index = freeIndices.back();
+        freeIndices.pop_back();
+        return index;
+    }
+
+    if (nextUnused == capacity) {
+        throw std::runtime_error("bindless descriptor array is full!");
+    }
+
+    return nextUnused++;
+}
+
+uint32_t BindlessDescriptors::addTexture(VkImageView imageView, VkSampler sampler) {
+    uint32_t index = textureIndices.allocate();
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = TEXTURE_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    return index;
+}
+
+uint32_t BindlessDescriptors::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    uint32_t index = bufferIndices.allocate();
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = BUFFER_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    return index;
+}
+
+void BindlessDescriptors::removeTexture(uint32_t index, uint64_t frameNumber) {
+    textureIndices.releasedIndices.push_back(ReleasedIndex{ index, frameNumber });
+}
+
+void BindlessDescriptors::removeBuffer(uint32_t index, uint64_t frameNumber) {
+    bufferIndices.releasedIndices.push_back(ReleasedIndex{ index, frameNumber });
+}
+
+void BindlessDescriptors::beginFrame(uint64_t frameNumber) {
+    recycle(textureIndices, frameNumber);
+    recycle(bufferIndices, frameNumber);
+}
+
+void BindlessDescriptors::recycle(IndexAllocator& indices, uint64_t frameNumber) {
+    // every frame up to (frameNumber - framesInFlight) has completed, including the last one that may use the index
+    for (auto it = indices.releasedIndices.begin(); it != indices.releasedIndices.end();) {
+        if (frameNumber >= it->releasedAtFrame + framesInFlight) {
+            indices.freeIndices.push_back(it->index);
+            it = indices.releasedIndices.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// One descriptor set with a large array of textures (binding 0) and one of storage buffers (binding 1), built on
+// VK_EXT_descriptor_indexing. It is bound once per command buffer and shaders pick their resources with indices from
+// per-draw data, so switching materials never binds another set. Both arrays are partially bound and update-after-bind:
+// new resources are written into free elements while the set is in use by frames in flight.
+//
+// Indices are handed out from a free list. A removed index stays reserved until the frames that may still read it have
+// completed, so an element is never rewritten while a pending command buffer uses it.
+class BindlessDescriptors {
+public:
+    static constexpr uint32_t TEXTURE_BINDING = 0;
+    static constexpr uint32_t BUFFER_BINDING = 1;
+
+    // the instance needs VK_KHR_get_physical_device_properties2
+    static bool isSupported(VkInstance instance, VkPhysicalDevice physicalDevice, uint32_t textureCapacity, uint32_t bufferCapacity);
+
+    // to be enabled on the device, with getRequiredFeatures() in the VkDeviceCreateInfo pNext chain and
+    // enableRequiredCoreFeatures() applied to its pEnabledFeatures
+    static const std::vector<const char*>& getRequiredExtensions();
+    static VkPhysicalDeviceDescriptorIndexingFeaturesEXT getRequiredFeatures();
+    static void enableRequiredCoreFeatures(VkPhysicalDeviceFeatures& features);
+
+    BindlessDescriptors(VkDevice device, VkShaderStageFlags stages, uint32_t textureCapacity, uint32_t bufferCapacity, uint32_t framesInFlight);
+    ~BindlessDescriptors();
+
+    BindlessDescriptors(const BindlessDescriptors&) = delete;
+    BindlessDescriptors& operator=(const BindlessDescriptors&) = delete;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    // what the layout was created with, to check shaders against
+    const std::vector<VkDescriptorSetLayoutBinding>& getDescriptorSetLayoutBindings() const { return layoutBindings; }
+    VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+
+    // the returned index selects the resource in the shader; the image view must be in SHADER_READ_ONLY_OPTIMAL
+    uint32_t addTexture(VkImageView imageView, VkSampler sampler);
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+
+    // frameNumber is the frame being recorded; the index is free again framesInFlight frames later
+    void removeTexture(uint32_t index, uint64_t frameNumber);
+    void removeBuffer(uint32_t index, uint64_t frameNumber);
+
+    // once the frame slot's previous frame has completed; recycles the indices no frame in flight can still use
+    void beginFrame(uint64_t frameNumber);
+
+private:
+    struct ReleasedIndex {
+        uint32_t index;
+        uint64_t releasedAtFrame;
+    };
+
+    struct IndexAllocator {
+        uint32_t capacity;
+        uint32_t nextUnused = 0;
+        std::vector<uint32_t> freeIndices;
+        std::vector<ReleasedIndex> releasedIndices;
+
+        uint32_t allocate();
+    };
+
+    void recycle(IndexAllocator& indices, uint64_t frameNumber);
+
+    VkDevice device;
+    uint32_t framesInFlight;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+
+    IndexAllocator textureIndices;
+    IndexAllocator bufferIndices;
+};
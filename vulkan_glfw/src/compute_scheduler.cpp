@@ -0,0 +1,120 @@
+#include "compute_scheduler.h"
+
+#include <stdexcept>
+
+// everything that may read the results of a compute pass on the graphics queue
+static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+static constexpr VkAccessFlags CONSUMER_ACCESS = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+ComputeScheduler::ComputeScheduler(VkDevice device, VkQueue computeQueue, uint32_t computeQueueFamilyIndex, TimelineScheduler* computeTimeline, uint32_t slotCount) :
+    device(device),
+    computeQueue(computeQueue),
+    computeTimeline(computeTimeline) {
+    if (!isAsync()) {
+        return;
+    }
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo{};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = computeQueueFamilyIndex;
+
+    if (vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute command pool!");
+    }
+
+    commandBuffers.resize(slotCount);
+    slotValues.assign(slotCount, 0);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool;
+    allocInfo.commandBufferCount = slotCount;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate compute command buffers!");
+    }
+}
+
+ComputeScheduler::~ComputeScheduler() {
+    if (!isAsync()) {
+        return;
+    }
+
+    computeTimeline->wait(computeTimeline->getSubmittedValue());
+
+    // destroying the pool frees its command buffers
+    vkDestroyCommandPool(device, commandPool, nullptr);
+}
+
+void ComputeScheduler::addPass(RecordFunction recordPass) {
+    passes.push_back(std::move(recordPass));
+}
+
+std::optional<TimelineScheduler::Wait> ComputeScheduler::flush(uint32_t slot, VkCommandBuffer graphicsCommandBuffer, const TimelineScheduler::Wait& graphicsWait) {
+    if (passes.empty()) {
+        return std::nullopt;
+    }
+
+    if (!isAsync()) {
+        recordInline(graphicsCommandBuffer);
+        passes.clear();
+        return std::nullopt;
+    }
+
+    // the slot's command buffer may still be executing; this only waits when the compute queue is a full round behind
+    computeTimeline->wait(slotValues[slot]);
+
+    VkCommandBuffer commandBuffer = commandBuffers[slot];
+
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording compute command buffer!");
+    }
+
+    for (const auto& recordPass : passes) {
+        recordPass(commandBuffer);
+    }
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record compute command buffer!");
+    }
+
+    passes.clear();
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    // the semaphore wait also makes the graphics queue's writes visible, so the passes need no barrier against them
+    timelineWaits.assign(1, graphicsWait);
+
+    if (computeTimeline->submit(computeQueue, submitInfo, slotValues[slot], timelineWaits) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit compute command buffer!");
+    }
+
+    return TimelineScheduler::Wait{ computeTimeline, slotValues[slot], CONSUMER_STAGES };
+}
+
+void ComputeScheduler::recordInline(VkCommandBuffer commandBuffer) {
+    // the passes may overwrite what earlier frames still read
+    vkCmdPipelineBarrier(commandBuffer, CONSUMER_STAGES, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    for (const auto& recordPass : passes) {
+        recordPass(commandBuffer);
+    }
+
+    VkMemoryBarrier resultBarrier{};
+    resultBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    resultBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    resultBarrier.dstAccessMask = CONSUMER_ACCESS;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, CONSUMER_STAGES, 0, 1, &resultBarrier, 0, nullptr, 0, nullptr);
+}
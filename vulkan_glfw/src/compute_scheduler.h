@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "timeline_scheduler.h"
+
+// Places the compute passes of a frame either on a queue of their own or into the frame's graphics command buffer.
+//
+// With a compute queue, the passes are recorded into one command buffer per frame slot and submitted to the compute
+// queue, where they overlap with the graphics work that does not depend on them. The submission signals the compute
+// queue's timeline; the graphics submission that reads the results waits for that value. Without one, the passes are
+// recorded inline, between barriers against the graphics work around them, so both modes can be compared.
+class ComputeScheduler {
+public:
+    using RecordFunction = std::function<void(VkCommandBuffer)>;
+
+    // computeQueue is VK_NULL_HANDLE to record the passes inline; computeTimeline is only used with a compute queue
+    ComputeScheduler(VkDevice device, VkQueue computeQueue, uint32_t computeQueueFamilyIndex, TimelineScheduler* computeTimeline, uint32_t slotCount);
+    ~ComputeScheduler();
+
+    ComputeScheduler(const ComputeScheduler&) = delete;
+    ComputeScheduler& operator=(const ComputeScheduler&) = delete;
+
+    bool isAsync() const { return computeQueue != VK_NULL_HANDLE; }
+
+    // recorded, in the order they were added, by the next flush()
+    void addPass(RecordFunction recordPass);
+
+    // records the passes added since the last flush. On the compute queue, they start once graphicsWait is reached,
+    // and the returned wait must be added to the graphics submission that reads their results. Inline, they are
+    // recorded into graphicsCommandBuffer, outside of a render pass, and nothing is returned.
+    std::optional<TimelineScheduler::Wait> flush(uint32_t slot, VkCommandBuffer graphicsCommandBuffer, const TimelineScheduler::Wait& graphicsWait);
+
+private:
+    void recordInline(VkCommandBuffer commandBuffer);
+
+    VkDevice device;
+    VkQueue computeQueue;
+    TimelineScheduler* computeTimeline;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> commandBuffers;
+    // timeline value signaled by each slot's last submission, 0 before the first one
+    std::vector<uint64_t> slotValues;
+
+    std::vector<RecordFunction> passes;
+    std::vector<TimelineScheduler::Wait> timelineWaits;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// SPIR-V compiled into the executable when it is built with VULKAN_GLFW_EMBED_SHADERS. The build generates the
+// definitions (cmake/embed_spirv.cmake) from the same binaries it puts into shaders/, as constexpr uint32_t arrays, so
+// the words are aligned and can go to vkCreateShaderModule as they are.
+struct EmbeddedShader {
+    // file name in shaders/, e.g. shader_vert.spv
+    std::string_view name;
+    std::span<const uint32_t> code;
+};
+
+std::span<const EmbeddedShader> getEmbeddedShaders();
@@ -0,0 +1,208 @@
+#include "frame_capture.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+static bool isBgra(VkFormat format) {
+    return format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+}
+
+bool FrameCapture::isFormatSupported(VkFormat format) {
+    return isBgra(format) || format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+FrameCapture::FrameCapture(VkDevice device, DeviceMemoryAllocator& allocator, uint32_t slotCount, std::filesystem::path outputDirectory) :
+    device(device),
+    allocator(allocator),
+    outputDirectory(std::move(outputDirectory)) {
+    std::filesystem::create_directories(this->outputDirectory);
+
+    for (uint32_t i = 0; i < slotCount; i++) {
+        slots.push_back(std::make_unique<Slot>());
+    }
+
+    worker = std::thread(&FrameCapture::workerLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+    for (uint32_t i = 0; i < slots.size(); i++) {
+        collect(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+
+    condition.notify_one();
+    worker.join();
+
+    std::cout << "[capture] written: " << writtenCount << ", dropped: " << droppedCount << std::endl;
+
+    for (auto& slot : slots) {
+        if (slot->buffer != VK_NULL_HANDLE) {
+            destroyBuffer(device, allocator, slot->buffer, slot->allocation);
+        }
+    }
+}
+
+void FrameCapture::collect(uint32_t slot) {
+    if (slots[slot]->state.load(std::memory_order_acquire) != SlotState::Recorded) {
+        return;
+    }
+
+    slots[slot]->state.store(SlotState::Encoding, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(slot);
+    }
+
+    condition.notify_one();
+}
+
+bool FrameCapture::record(VkCommandBuffer commandBuffer, uint32_t slotIndex, uint64_t frameNumber, VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent) {
+    Slot& slot = *slots[slotIndex];
+
+    // the worker is still writing the previous capture from this slot
+    if (slot.state.load(std::memory_order_acquire) != SlotState::Free || !isFormatSupported(format)) {
+        droppedCount++;
+        return false;
+    }
+
+    VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+    // the slot's previous frame has completed and the worker is done with it, so the buffer can be replaced
+    if (slot.capacity < size) {
+        if (slot.buffer != VK_NULL_HANDLE) {
+            destroyBuffer(device, allocator, slot.buffer, slot.allocation);
+        }
+
+        createBuffer(device, allocator, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, slot.buffer, slot.allocation);
+        slot.capacity = size;
+    }
+
+    VkImageSubresourceRange subresourceRange{};
+    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subresourceRange.levelCount = 1;
+    subresourceRange.layerCount = 1;
+
+    // the render pass' external dependency already orders the color writes before transfers;
+    // swap chain images still have to move to TRANSFER_SRC_OPTIMAL
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = 0;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout = layout;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = image;
+    toTransfer.subresourceRange = subresourceRange;
+
+    uint32_t imageBarrierCount = layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL ? 0 : 1;
+
+    if (imageBarrierCount > 0) {
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+    }
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0; // tightly packed
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { extent.width, extent.height, 1 };
+
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    // make the copy visible to the host once the frame has completed
+    VkBufferMemoryBarrier toHost{};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = slot.buffer;
+    toHost.offset = 0;
+    toHost.size = size;
+
+    // and give the image back in the layout it came in (e.g. PRESENT_SRC_KHR for swap chain images)
+    VkImageMemoryBarrier toOriginalLayout = toTransfer;
+    toOriginalLayout.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toOriginalLayout.dstAccessMask = 0;
+    toOriginalLayout.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toOriginalLayout.newLayout = layout;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &toHost, imageBarrierCount, &toOriginalLayout);
+
+    slot.frameNumber = frameNumber;
+    slot.format = format;
+    slot.extent = extent;
+    slot.state.store(SlotState::Recorded, std::memory_order_release);
+
+    return true;
+}
+
+void FrameCapture::workerLoop() {
+    while (true) {
+        uint32_t slotIndex;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return isStopping || !jobs.empty(); });
+
+            if (jobs.empty()) {
+                return;
+            }
+
+            slotIndex = jobs.front();
+            jobs.pop_front();
+        }
+
+        encode(*slots[slotIndex]);
+
+        slots[slotIndex]->state.store(SlotState::Free, std::memory_order_release);
+    }
+}
+
+void FrameCapture::encode(const Slot& slot) {
+    auto width = static_cast<int>(slot.extent.width);
+    auto height = static_cast<int>(slot.extent.height);
+    size_t size = static_cast<size_t>(width) * height * 4;
+
+    const auto* pixels = static_cast<const unsigned char*>(slot.allocation.mappedData);
+
+    // PNG wants RGBA; swap chains are usually BGRA
+    std::vector<unsigned char> swizzled;
+
+    if (isBgra(slot.format)) {
+        swizzled.assign(pixels, pixels + size);
+
+        for (size_t i = 0; i < size; i += 4) {
+            std::swap(swizzled[i], swizzled[i + 2]);
+        }
+
+        pixels = swizzled.data();
+    }
+
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "frame_%06llu.png", static_cast<unsigned long long>(slot.frameNumber));
+
+    std::filesystem::path path = outputDirectory / fileName;
+
+    if (!stbi_write_png(path.string().c_str(), width, height, 4, pixels, width * 4)) {
+        std::cerr << "[capture] Failed to write '" << path.string() << "'" << std::endl;
+        return;
+    }
+
+    writtenCount++;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "memory_allocator.h"
+
+// Asynchronous frame readback: one host-visible buffer per frame slot receives a copy of the rendered image in
+// the frame's own command buffer. Once the slot's previous frame has completed, the buffer is handed to a worker thread
+// that writes it out as a PNG. Nothing here ever waits: if the worker still holds a slot's buffer when the slot
+// comes around again, that capture is dropped.
+class FrameCapture {
+public:
+    FrameCapture(VkDevice device, DeviceMemoryAllocator& allocator, uint32_t slotCount, std::filesystem::path outputDirectory);
+
+    // the device must be idle: captures that are still recorded are encoded before the worker stops
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // call once the slot's previous frame has completed; passes a completed copy on to the worker
+    void collect(uint32_t slot);
+
+    // records the copy of image (which is in layout and stays in it) into the slot's buffer;
+    // returns false when the capture was dropped
+    bool record(VkCommandBuffer commandBuffer, uint32_t slot, uint64_t frameNumber, VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent);
+
+    static bool isFormatSupported(VkFormat format);
+
+    uint64_t getWrittenCount() const { return writtenCount; }
+    uint64_t getDroppedCount() const { return droppedCount; }
+
+private:
+    enum class SlotState {
+        Free,
+        Recorded, // copy submitted with the slot's frame
+        Encoding // owned by the worker
+    };
+
+    struct Slot {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        Allocation allocation;
+        VkDeviceSize capacity = 0;
+        std::atomic<SlotState> state{ SlotState::Free };
+
+        uint64_t frameNumber = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+    };
+
+    void workerLoop();
+    void encode(const Slot& slot);
+
+    VkDevice device;
+    DeviceMemoryAllocator& allocator;
+    std::filesystem::path outputDirectory;
+
+    std::vector<std::unique_ptr<Slot>> slots;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<uint32_t> jobs;
+    bool isStopping = false;
+    std::thread worker;
+
+    std::atomic<uint64_t> writtenCount{ 0 };
+    std::atomic<uint64_t> droppedCount{ 0 };
+};
@@ -0,0 +1,213 @@
+#include "gpu_culling.h"
+
+#include <stdexcept>
+
+// matches the push constant block of shaders/cull.comp
+struct CullingPushConstants {
+    glm::vec4 frustumPlanes[GpuCulling::FRUSTUM_PLANE_COUNT];
+    uint32_t objectCount;
+    uint32_t indexCount;
+    uint32_t isCompacting;
+};
+
+GpuCulling::GpuCulling(VkDevice device, DeviceMemoryAllocator& allocator, VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode, uint32_t objectCount, uint32_t indexCount, uint32_t slotCount, PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount) :
+    device(device),
+    allocator(allocator),
+    objectCount(objectCount),
+    indexCount(indexCount),
+    drawIndexedIndirectCount(drawIndexedIndirectCount),
+    slots(slotCount) {
+    createBuffer(device, allocator, getObjectBufferSize(), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, objectBuffer, objectAllocation);
+
+    for (auto& slot : slots) {
+        createBuffer(device, allocator, sizeof(VkDrawIndexedIndirectCommand) * objectCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, slot.drawCommandBuffer, slot.drawCommandAllocation);
+        createBuffer(device, allocator, sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, slot.drawCountBuffer, slot.drawCountAllocation);
+    }
+
+    // objects, draw commands, draw count
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culling descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = static_cast<uint32_t>(bindings.size()) * slotCount;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = slotCount;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culling descriptor pool!");
+    }
+
+    for (auto& slot : slots) {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(device, &allocInfo, &slot.descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate culling descriptor set!");
+        }
+
+        std::array<VkDescriptorBufferInfo, 3> bufferInfos = {{
+            { objectBuffer, 0, VK_WHOLE_SIZE },
+            { slot.drawCommandBuffer, 0, VK_WHOLE_SIZE },
+            { slot.drawCountBuffer, 0, VK_WHOLE_SIZE }
+        }};
+
+        std::array<VkWriteDescriptorSet, 3> writes{};
+
+        for (uint32_t i = 0; i < writes.size(); i++) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = slot.descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CullingPushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culling pipeline layout!");
+    }
+
+    VkShaderModuleCreateInfo shaderInfo{};
+    shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderInfo.codeSize = shaderCode.size_bytes();
+    shaderInfo.pCode = shaderCode.data();
+
+    VkShaderModule shaderModule;
+
+    if (vkCreateShaderModule(device, &shaderInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culling shader module!");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+
+    VkResult result = vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create culling pipeline!");
+    }
+}
+
+GpuCulling::~GpuCulling() {
+    vkDestroyPipeline(device, pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+
+    // destroying the pool frees its sets
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+    for (auto& slot : slots) {
+        destroyBuffer(device, allocator, slot.drawCountBuffer, slot.drawCountAllocation);
+        destroyBuffer(device, allocator, slot.drawCommandBuffer, slot.drawCommandAllocation);
+    }
+
+    destroyBuffer(device, allocator, objectBuffer, objectAllocation);
+}
+
+void GpuCulling::recordCulling(VkCommandBuffer commandBuffer, uint32_t slot, const FrustumPlanes& frustumPlanes) {
+    const Slot& resources = slots[slot];
+
+    // the compacting shader appends to the count
+    if (isCompacting()) {
+        vkCmdFillBuffer(commandBuffer, resources.drawCountBuffer, 0, sizeof(uint32_t), 0);
+
+        VkBufferMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        clearBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        clearBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        clearBarrier.buffer = resources.drawCountBuffer;
+        clearBarrier.offset = 0;
+        clearBarrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &clearBarrier, 0, nullptr);
+    }
+
+    CullingPushConstants pushConstants{};
+
+    for (uint32_t i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        pushConstants.frustumPlanes[i] = frustumPlanes[i];
+    }
+
+    pushConstants.objectCount = objectCount;
+    pushConstants.indexCount = indexCount;
+    pushConstants.isCompacting = isCompacting() ? 1 : 0;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &resources.descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+    // the draw reads the commands and the count as indirect parameters
+    std::array<VkBufferMemoryBarrier, 2> drawBarriers{};
+
+    for (auto& barrier : drawBarriers) {
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+    }
+
+    drawBarriers[0].buffer = resources.drawCommandBuffer;
+    drawBarriers[1].buffer = resources.drawCountBuffer;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, isCompacting() ? 2 : 1, drawBarriers.data(), 0, nullptr);
+}
+
+void GpuCulling::recordDraw(VkCommandBuffer commandBuffer, uint32_t slot) {
+    const Slot& resources = slots[slot];
+
+    if (isCompacting()) {
+        drawIndexedIndirectCount(commandBuffer, resources.drawCommandBuffer, 0, resources.drawCountBuffer, 0, objectCount, sizeof(VkDrawIndexedIndirectCommand));
+    } else {
+        vkCmdDrawIndexedIndirect(commandBuffer, resources.drawCommandBuffer, 0, objectCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
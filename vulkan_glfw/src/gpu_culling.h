@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "memory_allocator.h"
+
+// GPU-driven drawing of many copies of one mesh. A compute pass tests every object's bounding sphere against the
+// frustum and writes a VkDrawIndexedIndirectCommand for each visible one, whose firstInstance is the object index, so
+// the object buffer doubles as the per-instance vertex buffer. The scene is then drawn with a single
+// vkCmdDrawIndexedIndirectCount; without it, every object gets a command (with instanceCount 0 when culled) and the
+// scene is drawn with one multi-draw vkCmdDrawIndexedIndirect. Either way the CPU cost does not depend on the number
+// of objects.
+//
+// The draw commands and the count have one copy per frame slot, so culling a frame never waits for the previous one.
+class GpuCulling {
+public:
+    // xy center, z scale of the mesh, w bounding sphere radius
+    using Object = glm::vec4;
+
+    static constexpr uint32_t FRUSTUM_PLANE_COUNT = 6;
+    static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+    // planes as xyz normal pointing into the frustum and w distance, so inside is dot(normal, p) + w >= 0
+    using FrustumPlanes = std::array<glm::vec4, FRUSTUM_PLANE_COUNT>;
+
+    // drawIndexedIndirectCount is null when VK_KHR_draw_indirect_count is not available; the device then needs the
+    // multiDrawIndirect feature. drawIndirectFirstInstance is needed in both cases.
+    GpuCulling(VkDevice device, DeviceMemoryAllocator& allocator, VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode, uint32_t objectCount, uint32_t indexCount, uint32_t slotCount, PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount);
+    ~GpuCulling();
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    // device local, usable as a vertex buffer; filled by the caller
+    VkBuffer getObjectBuffer() const { return objectBuffer; }
+    VkDeviceSize getObjectBufferSize() const { return sizeof(Object) * objectCount; }
+
+    bool isCompacting() const { return drawIndexedIndirectCount != nullptr; }
+
+    // outside of a render pass; the slot's previous frame must have completed
+    void recordCulling(VkCommandBuffer commandBuffer, uint32_t slot, const FrustumPlanes& frustumPlanes);
+
+    // inside the render pass, with the pipeline, the mesh and the object buffer (as per-instance data) bound
+    void recordDraw(VkCommandBuffer commandBuffer, uint32_t slot);
+
+private:
+    struct Slot {
+        VkBuffer drawCommandBuffer;
+        Allocation drawCommandAllocation;
+        VkBuffer drawCountBuffer;
+        Allocation drawCountAllocation;
+        VkDescriptorSet descriptorSet;
+    };
+
+    VkDevice device;
+    DeviceMemoryAllocator& allocator;
+    uint32_t objectCount;
+    uint32_t indexCount;
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount;
+
+    VkBuffer objectBuffer;
+    Allocation objectAllocation;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+
+    std::vector<Slot> slots;
+};
@@ -0,0 +1,216 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+static uint32_t getTimestampValidBits(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    return queueFamilyIndex < queueFamilyCount ? queueFamilies[queueFamilyIndex].timestampValidBits : 0;
+}
+
+bool GpuProfiler::isSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    return properties.limits.timestampPeriod > 0.0f && getTimestampValidBits(physicalDevice, queueFamilyIndex) > 0;
+}
+
+GpuProfiler::GpuProfiler(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t slotCount) :
+    device(device),
+    queriesPerSlot(MAX_SCOPES_PER_FRAME * 2),
+    slots(slotCount) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    uint32_t validBits = getTimestampValidBits(physicalDevice, queueFamilyIndex);
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    createInfo.queryCount = queriesPerSlot * slotCount;
+
+    if (vkCreateQueryPool(device, &createInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+void GpuProfiler::beginFrame(uint32_t slot, uint64_t frameNumber) {
+    collect(slots[slot], slot);
+
+    slots[slot].frameNumber = frameNumber;
+    currentSlot = slot;
+    isResetPending = true;
+    openScopes.clear();
+}
+
+void GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name) {
+    // the queries were last used one full round of frames ago and have been read back since
+    if (isResetPending) {
+        vkCmdResetQueryPool(commandBuffer, queryPool, currentSlot * queriesPerSlot, queriesPerSlot);
+        isResetPending = false;
+    }
+
+    Slot& slot = slots[currentSlot];
+
+    // keep one query free for the end of this scope and of every scope it is nested in
+    if (slot.queryCount + 1 + openScopes.size() + 1 > queriesPerSlot) {
+        openScopes.push_back(UINT32_MAX);
+        return;
+    }
+
+    uint32_t query = slot.queryCount++;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, currentSlot * queriesPerSlot + query);
+
+    openScopes.push_back(static_cast<uint32_t>(slot.scopes.size()));
+    slot.scopes.push_back(Scope{ name, static_cast<uint32_t>(openScopes.size() - 1), query, UINT32_MAX });
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer) {
+    if (openScopes.empty()) {
+        return;
+    }
+
+    uint32_t scopeIndex = openScopes.back();
+    openScopes.pop_back();
+
+    if (scopeIndex == UINT32_MAX) {
+        return;
+    }
+
+    Slot& slot = slots[currentSlot];
+
+    uint32_t query = slot.queryCount++;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, currentSlot * queriesPerSlot + query);
+
+    slot.scopes[scopeIndex].endQuery = query;
+}
+
+void GpuProfiler::collectAll() {
+    // oldest frame first, so the trace stays in order
+    std::vector<uint32_t> order;
+
+    for (uint32_t i = 0; i < slots.size(); i++) {
+        if (slots[i].queryCount > 0) {
+            order.push_back(i);
+        }
+    }
+
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return slots[a].frameNumber < slots[b].frameNumber;
+    });
+
+    for (uint32_t i : order) {
+        collect(slots[i], i);
+    }
+}
+
+void GpuProfiler::collect(Slot& slot, uint32_t slotIndex) {
+    if (slot.queryCount == 0) {
+        return;
+    }
+
+    std::vector<uint64_t> timestamps(slot.queryCount);
+
+    // no VK_QUERY_RESULT_WAIT_BIT: the slot's previous frame has completed, so the results are available
+    VkResult result = vkGetQueryPoolResults(device, queryPool, slotIndex * queriesPerSlot, slot.queryCount, timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+    if (result == VK_SUCCESS) {
+        for (const Scope& scope : slot.scopes) {
+            if (scope.endQuery == UINT32_MAX) {
+                continue;
+            }
+
+            uint64_t begin = timestamps[scope.beginQuery] & timestampMask;
+            uint64_t end = timestamps[scope.endQuery] & timestampMask;
+            double durationNs = static_cast<double>((end - begin) & timestampMask) * timestampPeriod;
+
+            RollingAverage& average = averages[scope.name];
+            average.values.push_back(durationNs / 1e6);
+            average.sum += durationNs / 1e6;
+
+            if (average.values.size() > ROLLING_WINDOW) {
+                average.sum -= average.values.front();
+                average.values.pop_front();
+            }
+
+            if (!hasTraceOrigin) {
+                traceOrigin = begin;
+                hasTraceOrigin = true;
+            }
+
+            if (traceEvents.size() < MAX_TRACE_EVENTS) {
+                double startNs = static_cast<double>((begin - traceOrigin) & timestampMask) * timestampPeriod;
+                traceEvents.push_back(TraceEvent{ scope.name, slot.frameNumber, startNs / 1e3, durationNs / 1e3 });
+            }
+        }
+    }
+
+    slot.scopes.clear();
+    slot.queryCount = 0;
+}
+
+double GpuProfiler::getAverageMs(const std::string& name) const {
+    auto it = averages.find(name);
+
+    if (it == averages.end() || it->second.values.empty()) {
+        return 0.0;
+    }
+
+    return it->second.sum / it->second.values.size();
+}
+
+void GpuProfiler::printAverages() const {
+    std::cout << "[gpu profiler]";
+
+    const char* separator = " ";
+
+    for (const auto& [name, average] : averages) {
+        std::cout << separator << name << ": " << getAverageMs(name) << " ms";
+        separator = ", ";
+    }
+
+    std::cout << std::endl;
+}
+
+bool GpuProfiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+
+    if (!out.is_open()) {
+        std::cerr << "[gpu profiler] Failed to open '" << path << "' for writing" << std::endl;
+        return false;
+    }
+
+    // timestamps are in microseconds and get large, keep them out of scientific notation
+    out << std::fixed;
+    out.precision(3);
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+    for (size_t i = 0; i < traceEvents.size(); i++) {
+        const TraceEvent& event = traceEvents[i];
+
+        out << "  {\"name\": \"" << event.name << "\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+            << ", \"ts\": " << event.startUs << ", \"dur\": " << event.durationUs
+            << ", \"args\": {\"frame\": " << event.frameNumber << "}}"
+            << (i + 1 < traceEvents.size() ? ",\n" : "\n");
+    }
+
+    out << "]}\n";
+
+    std::cout << "[gpu profiler] trace with " << traceEvents.size() << " event(s) written to '" << path << "'" << std::endl;
+
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// GPU timestamps around nestable scopes, one range of queries per frame slot. The queries of a slot are read back
+// when the slot comes around again, after its previous frame has completed, so reading them never stalls.
+//
+// Scopes may be recorded into any command buffer of the frame, as long as the command buffers are recorded in the
+// order they are submitted in: the first scope of a frame resets the slot's queries, so it must be recorded outside a
+// render pass and into the first command buffer that is submitted.
+class GpuProfiler {
+public:
+    static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+
+    // the rolling averages cover the last ROLLING_WINDOW occurrences of each scope
+    static constexpr size_t ROLLING_WINDOW = 120;
+
+    // the trace stops growing after this many events
+    static constexpr size_t MAX_TRACE_EVENTS = 1 << 20;
+
+    GpuProfiler(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t slotCount);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    static bool isSupported(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+
+    // call once the slot's previous frame has completed; reads back the scopes of the slot's previous frame
+    void beginFrame(uint32_t slot, uint64_t frameNumber);
+
+    void beginScope(VkCommandBuffer commandBuffer, const char* name);
+    void endScope(VkCommandBuffer commandBuffer);
+
+    // the device must be idle; reads back every slot that has not been read yet
+    void collectAll();
+
+    // 0 if the scope has not completed yet
+    double getAverageMs(const std::string& name) const;
+
+    void printAverages() const;
+
+    // Chrome trace event format, open with chrome://tracing or https://ui.perfetto.dev
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    struct Scope {
+        std::string name;
+        uint32_t depth;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+    };
+
+    struct Slot {
+        std::vector<Scope> scopes;
+        uint32_t queryCount = 0;
+        uint64_t frameNumber = 0;
+    };
+
+    struct RollingAverage {
+        std::deque<double> values;
+        double sum = 0.0;
+    };
+
+    struct TraceEvent {
+        std::string name;
+        uint64_t frameNumber;
+        double startUs;
+        double durationUs;
+    };
+
+    void collect(Slot& slot, uint32_t slotIndex);
+
+    VkDevice device;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    uint32_t queriesPerSlot;
+    double timestampPeriod; // nanoseconds per tick
+    uint64_t timestampMask;
+
+    std::vector<Slot> slots;
+    uint32_t currentSlot = 0;
+    bool isResetPending = false;
+
+    // indices into the current slot's scopes, UINT32_MAX for scopes that did not fit
+    std::vector<uint32_t> openScopes;
+
+    std::map<std::string, RollingAverage> averages;
+
+    std::vector<TraceEvent> traceEvents;
+    bool hasTraceOrigin = false;
+    uint64_t traceOrigin = 0;
+};
@@ -8,8 +8,40 @@
 #include <set>
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <bit>
+#include <charconv>
+#include <cmath>
 #include <glm/glm.hpp>
 
+#include <frame_benchmark.h>
+
+#include "async_log.h"
+#include "bindless_descriptors.h"
+#include "compute_scheduler.h"
+#include "embedded_shaders.h"
+#include "frame_capture.h"
+#include "gpu_culling.h"
+#include "gpu_profiler.h"
+#include "memory_allocator.h"
+#include "offscreen_targets.h"
+#include "parallel_recorder.h"
+#include "particle_simulation.h"
+#include "pipeline_cache.h"
+#include "pipeline_layout_cache.h"
+#include "pipeline_variants.h"
+#include "shader_hot_reload.h"
+#include "shader_reflection.h"
+#include "startup_profiler.h"
+#include "swap_chain.h"
+#include "timeline_scheduler.h"
+#include "uniform_ring.h"
+#include "upload_queue.h"
+
 struct Vertex {
     glm::vec2 pos;
     glm::vec3 color;
@@ -41,6 +73,51 @@ struct Vertex {
     }
 };
 
+// per-instance data for the instanced pipeline, read from vertex binding 1
+struct InstanceData {
+    glm::vec4 transform; // xy offset, zw scale
+    glm::vec4 color;
+
+    static VkVertexInputBindingDescription getBindingDescription() {
+        VkVertexInputBindingDescription bindingDescription{};
+
+        bindingDescription.binding = 1;
+        bindingDescription.stride = sizeof(InstanceData);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+        return bindingDescription;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+
+        attributeDescriptions[0].binding = 1;
+        attributeDescriptions[0].location = 2;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(InstanceData, transform);
+
+        attributeDescriptions[1].binding = 1;
+        attributeDescriptions[1].location = 3;
+        attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributeDescriptions[1].offset = offsetof(InstanceData, color);
+
+        return attributeDescriptions;
+    }
+};
+
+// per-draw data of shaders/shader.vert: the uniform block lives in the uniform ring, the tint is a push constant
+struct DrawUniforms {
+    glm::mat4 transform;
+};
+
+struct DrawPushConstants {
+    glm::vec4 tint;
+
+    // bindless: array indices of the draw's texture and material, read by shaders/bindless.frag
+    uint32_t textureIndex;
+    uint32_t materialIndex;
+};
+
 const std::vector<Vertex> vertices = {
     {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
     {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
@@ -55,12 +132,68 @@ const std::vector<uint16_t> indices = {
 struct QueueFamilies {
     int graphicsQueueFamilyIndex;
     int presentationQueueFamilyIndex;
+    int transferQueueFamilyIndex; // transfer-only family, -1 when there is none
+    int computeQueueFamilyIndex; // compute family without graphics, -1 when there is none
+};
+
+struct FrameResources {
+    VkCommandBuffer commandBuffer;
+    VkSemaphore imageAvailableSemaphore;
+    // timeline value signaled by the slot's last frame, 0 before the first one
+    uint64_t timelineValue = 0;
+
+    // instancing: persistently mapped, rewritten every time the slot is used
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    Allocation instanceAllocation;
+};
+
+struct Options {
+    uint32_t framesInFlight = 2;
+    uint32_t benchmarkFrames = 0;
+    std::string benchmarkOutput;
+    uint32_t allocatorStressBuffers = 0;
+    bool usePipelineCache = true;
+    uint32_t resizeStormFrames = 0;
+    bool headless = false;
+    uint32_t captureEvery = 0;
+    std::string captureDirectory = "captures";
+    bool gpuProfile = false;
+    std::string gpuTracePath = "gpu_trace.json";
+    uint32_t recordThreads = 0; // 0 records inline into the primary command buffer
+    uint32_t draws = 1;
+    uint32_t gpuCullingObjects = 0; // 0 draws the single quad from the CPU
+    uint32_t instances = 0; // 0 draws without the instanced pipeline
+    bool bindless = false;
+    bool dynamicRendering = false;
+    bool useTransferQueue = true;
+    uint32_t uploadStressMegabytes = 0; // per frame
+    uint32_t particles = 0; // 0 runs no particle simulation
+    bool useAsyncCompute = true;
+    bool fastStart = false;
+    bool useUnoptimizedShaders = false;
+    bool useShaderFiles = false; // load the shaders from shaders/ even when they are embedded
+    bool hotReload = false;
+    uint32_t pipelineVariants = 0; // 0 draws with the graphics pipeline only
+    uint32_t variantThreads = 0; // 0 compiles the variants on half the hardware threads
+    bool usePipelineLibrary = true;
+};
+
+struct Texture {
+    VkImage image;
+    Allocation allocation;
+    VkImageView imageView;
 };
 
-struct SwapChainSupportDetails {
-    VkSurfaceCapabilitiesKHR capabilities;
-    std::vector<VkSurfaceFormatKHR> formats;
-    std::vector<VkPresentModeKHR> presentModes;
+// the last frame that used the swap chain completes with lastUseValue on the timeline
+struct RetiredSwapChain {
+    SwapChain swapChain;
+    uint64_t lastUseValue;
+};
+
+// same for a pipeline replaced by a hot reload
+struct RetiredPipeline {
+    VkPipeline pipeline;
+    uint64_t lastUseValue;
 };
 
 static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
@@ -69,17 +202,9 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
     }
 }
 
-static uint32_t findMemoryType(VkPhysicalDevice device, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(device, &memProperties);
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    throw std::runtime_error("failed to find suitable memory type!");
+static void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
+    auto framebufferResized = static_cast<bool*>(glfwGetWindowUserPointer(window));
+    *framebufferResized = true;
 }
 
 static QueueFamilies findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface) {
@@ -97,6 +222,8 @@ static QueueFamilies findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR sur
 
     int graphicsQueueFamilyIndex = -1;
     int presentationQueueFamilyIndex = -1;
+    int transferQueueFamilyIndex = -1;
+    int computeQueueFamilyIndex = -1;
 
     std::cout << "[findQueueFamilies] Search for queue family..." << std::endl;
 
@@ -107,77 +234,51 @@ static QueueFamilies findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR sur
             graphicsQueueFamilyIndex = i;
         }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-
-        if (presentSupport) {
-            std::cout << "[findQueueFamilies] Found presentation queue family at [" << i << "]" << std::endl;
+        // usually the copy engine of a discrete GPU, which runs alongside graphics and compute
+        if ((queueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamilies[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            std::cout << "[findQueueFamilies] Found dedicated transfer queue family at [" << i << "]" << std::endl;
 
-            presentationQueueFamilyIndex = i;
+            transferQueueFamilyIndex = i;
         }
-    }
-
-    return QueueFamilies{ .graphicsQueueFamilyIndex = graphicsQueueFamilyIndex, .presentationQueueFamilyIndex = presentationQueueFamilyIndex };
-}
-
-static SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface) {
-    SwapChainSupportDetails details;
-
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
 
-    uint32_t formatCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+        // async compute: a queue that runs compute work next to the graphics queue
+        if ((queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            std::cout << "[findQueueFamilies] Found async compute queue family at [" << i << "]" << std::endl;
 
-    if (formatCount != 0) {
-        details.formats.resize(formatCount);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
-    }
-
-    uint32_t presentModeCount;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
-
-    if (presentModeCount != 0) {
-        details.presentModes.resize(presentModeCount);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
-    }
+            computeQueueFamilyIndex = i;
+        }
 
-    return details;
-}
+        VkBool32 presentSupport = false;
 
-static VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
-    for (const auto& availableFormat : availableFormats) {
-        if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-            return availableFormat;
+        // headless: there is no surface to present to
+        if (surface != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
         }
-    }
 
-    return availableFormats[0];
-}
+        if (presentSupport) {
+            std::cout << "[findQueueFamilies] Found presentation queue family at [" << i << "]" << std::endl;
 
-static VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-    for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return availablePresentMode;
+            presentationQueueFamilyIndex = i;
         }
     }
 
-    return VK_PRESENT_MODE_FIFO_KHR;
+    return QueueFamilies{ .graphicsQueueFamilyIndex = graphicsQueueFamilyIndex, .presentationQueueFamilyIndex = presentationQueueFamilyIndex, .transferQueueFamilyIndex = transferQueueFamilyIndex, .computeQueueFamilyIndex = computeQueueFamilyIndex };
 }
 
-static VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int framebufferWidth, int framebufferHeight) {
-    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-        return capabilities.currentExtent;
-    }
+static bool isDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName) {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
-    VkExtent2D actualExtent = {
-        static_cast<uint32_t>(framebufferWidth),
-        static_cast<uint32_t>(framebufferHeight)
-    };
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-    actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-    actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    for (const auto& extension : availableExtensions) {
+        if (std::strcmp(extension.extensionName, extensionName) == 0) {
+            return true;
+        }
+    }
 
-    return actualExtent;
+    return false;
 }
 
 static bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface) {
@@ -196,13 +297,19 @@ static bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface) {
 
     auto queueFamilies = findQueueFamilies(device, surface);
 
-    bool hasQueueFamilies = queueFamilies.graphicsQueueFamilyIndex > -1 && queueFamilies.presentationQueueFamilyIndex > -1;
+    bool isHeadless = surface == VK_NULL_HANDLE;
+    bool hasQueueFamilies = queueFamilies.graphicsQueueFamilyIndex > -1 && (isHeadless || queueFamilies.presentationQueueFamilyIndex > -1);
 
     if (!hasQueueFamilies) {
         std::cerr << "[isDeviceSuitable] Device does not have compatible queue families" << std::endl;
         return false;
     }
 
+    // offscreen rendering needs neither the swap chain extension nor surface support
+    if (isHeadless) {
+        return true;
+    }
+
     const std::vector<const char*> deviceExtensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
@@ -242,7 +349,8 @@ static bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface) {
     return true;
 }
 
-static std::vector<char> readFile(const std::string& filename) {
+// read as words, so the code is aligned the way vkCreateShaderModule needs it
+static std::vector<uint32_t> readSpirvFile(const std::string& filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
     if (!file.is_open()) {
@@ -250,21 +358,74 @@ static std::vector<char> readFile(const std::string& filename) {
     }
 
     size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buffer(fileSize);
+
+    if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("failed to read SPIR-V: " + filename + " is not a whole number of words!");
+    }
+
+    std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
 
     file.seekg(0);
-    file.read(buffer.data(), fileSize);
+    file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
 
     file.close();
 
     return buffer;
 }
 
-static VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code) {
+// SPIR-V compiled into the executable, or read from a file
+struct ShaderBinary {
+    std::span<const uint32_t> embeddedCode;
+    std::vector<uint32_t> fileCode;
+
+    std::span<const uint32_t> getCode() const {
+        return embeddedCode.empty() ? std::span<const uint32_t>(fileCode) : embeddedCode;
+    }
+};
+
+static bool usesEmbeddedShaders(const Options& options) {
+#ifdef VULKAN_GLFW_EMBED_SHADERS
+    // only the optimized binaries are embedded
+    return !options.useShaderFiles && !options.useUnoptimizedShaders;
+#else
+    return false;
+#endif
+}
+
+static std::span<const uint32_t> findEmbeddedShader(const std::string& name) {
+#ifdef VULKAN_GLFW_EMBED_SHADERS
+    for (const auto& shader : getEmbeddedShaders()) {
+        if (shader.name == name) {
+            return shader.code;
+        }
+    }
+#endif
+
+    throw std::runtime_error("failed to find embedded shader " + name + "!");
+}
+
+// the build embeds the optimized shaders into the executable (VULKAN_GLFW_EMBED_SHADERS), and puts them next to it,
+// optimized by spirv-opt in shaders/ and as glslc emitted them in shaders/unoptimized/
+static ShaderBinary readShader(const Options& options, const std::string& name) {
+    ShaderBinary binary;
+
+    if (usesEmbeddedShaders(options)) {
+        binary.embeddedCode = findEmbeddedShader(name);
+    } else {
+        binary.fileCode = readSpirvFile((options.useUnoptimizedShaders ? "shaders/unoptimized/" : "shaders/") + name);
+    }
+
+    std::cout << "[shaders] " << name << ": " << binary.getCode().size_bytes() << " B"
+              << (binary.embeddedCode.empty() ? " (file" : " (embedded") << (options.useUnoptimizedShaders ? ", unoptimized)" : ")") << std::endl;
+
+    return binary;
+}
+
+static VkShaderModule createShaderModule(VkDevice device, std::span<const uint32_t> code) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    createInfo.codeSize = code.size_bytes();
+    createInfo.pCode = code.data();
 
     VkShaderModule shaderModule;
 
@@ -275,100 +436,375 @@ static VkShaderModule createShaderModule(VkDevice device, const std::vector<char
     return shaderModule;
 }
 
-static void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
-    VkBufferCreateInfo bufferInfo{};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = size;
-    bufferInfo.usage = usage;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+static void printAllocatorStats(const char* label, const AllocatorStats& stats) {
+    std::cout << "[allocator] " << label
+              << ": device memory allocations: " << stats.deviceMemoryAllocations
+              << ", sub-allocations: " << stats.allocationCount
+              << ", reserved: " << stats.bytesReserved << " B"
+              << ", used: " << stats.bytesUsed << " B"
+              << ", allocated: " << stats.bytesAllocated << " B"
+              << ", fragmentation: " << stats.fragmentation << std::endl;
+}
+
+// creates lots of small buffers to check they end up in a handful of VkDeviceMemory blocks
+static void runAllocatorStress(VkDevice device, DeviceMemoryAllocator& allocator, uint32_t bufferCount) {
+    std::cout << "Creating " << bufferCount << " small buffers..." << std::endl;
 
-    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create buffer!");
+    std::vector<VkBuffer> buffers(bufferCount);
+    std::vector<Allocation> allocations(bufferCount);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < bufferCount; i++) {
+        VkDeviceSize size = 64 + (i % 16) * 64;
+        createBuffer(device, allocator, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffers[i], allocations[i]);
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+    auto end = std::chrono::steady_clock::now();
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
+    printAllocatorStats("stress", allocator.getStats());
+    std::cout << "[allocator] created " << bufferCount << " buffers in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate buffer memory!");
+    // free every other buffer first to exercise buddy merging
+    for (uint32_t i = 0; i < bufferCount; i += 2) {
+        destroyBuffer(device, allocator, buffers[i], allocations[i]);
     }
 
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    printAllocatorStats("stress, half freed", allocator.getStats());
+
+    for (uint32_t i = 1; i < bufferCount; i += 2) {
+        destroyBuffer(device, allocator, buffers[i], allocations[i]);
+    }
 }
 
-static void copyBuffer(VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
+// lays the instances out on a square grid covering the viewport, each row pulsing in brightness
+static void writeInstances(InstanceData* instances, uint32_t instanceCount, float time) {
+    uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+    float cellSize = 2.0f / gridSize;
+    float scale = cellSize * 0.8f;
 
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+    for (uint32_t row = 0, i = 0; row < gridSize && i < instanceCount; row++) {
+        float brightness = 0.6f + 0.4f * std::sin(time * 3.0f + row * 0.2f);
+        float y = -1.0f + (row + 0.5f) * cellSize;
+
+        for (uint32_t column = 0; column < gridSize && i < instanceCount; column++, i++) {
+            instances[i].transform = glm::vec4(-1.0f + (column + 0.5f) * cellSize, y, scale, scale);
+            instances[i].color = glm::vec4(brightness * column / gridSize, brightness * row / gridSize, brightness, 1.0f);
+        }
+    }
+}
+
+// the i-th generated pipeline variant: each color mode of shader.frag with each blend mode, then all of them again at a
+// lower alpha, so every variant differs from the others
+static PipelineVariantCache::Variant getPipelineVariant(uint32_t i) {
+    float alpha = 1.0f / static_cast<float>(1 + i / 12);
+
+    PipelineVariantCache::Variant variant;
+    variant.blendMode = static_cast<PipelineVariantCache::BlendMode>((i / 4) % 3);
+    variant.fragmentConstants = { i % 4, std::bit_cast<uint32_t>(alpha) };
+
+    return variant;
+}
+
+// RGBA8 checkerboard of the given color and white
+static std::vector<uint32_t> createCheckerboard(uint32_t size, uint32_t cellSize, uint32_t color) {
+    std::vector<uint32_t> texels(size * size);
+
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            texels[y * size + x] = ((x / cellSize + y / cellSize) % 2 == 0) ? color : 0xffffffff;
+        }
+    }
+
+    return texels;
+}
+
+static void printUsage(const char* executableName) {
+    std::cerr << "Usage: " << executableName << " [--frames-in-flight N] [--benchmark-frames N] [--benchmark-output PATH] [--allocator-stress N] [--no-pipeline-cache] [--resize-storm N] [--headless] [--capture-every N] [--capture-dir PATH] [--gpu-profile] [--gpu-trace PATH] [--record-threads N] [--draws N] [--gpu-culling N] [--instances N] [--instance-stress] [--bindless] [--dynamic-rendering] [--no-transfer-queue] [--upload-stress MIB] [--particles N] [--no-async-compute] [--fast-start] [--unoptimized-shaders] [--shader-files] [--hot-reload] [--pipeline-variants N] [--variant-threads N] [--no-pipeline-library]" << std::endl;
+}
+
+static const uint32_t HEADLESS_DEFAULT_FRAMES = 1000;
+static const VkFormat HEADLESS_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+static const uint64_t GPU_PROFILER_REPORT_INTERVAL = 1000;
+
+// one culling invocation per object, and vkCmdDispatch takes at most 65535 workgroups
+static const uint32_t GPU_CULLING_MAX_OBJECTS = 65535 * GpuCulling::WORKGROUP_SIZE;
+static const float GPU_CULLING_OBJECT_SPACING = 0.05f;
+static const float GPU_CULLING_OBJECT_SCALE = 0.04f;
+static const uint32_t INSTANCE_STRESS_INSTANCES = 1000000;
+static const uint32_t INSTANCE_STRESS_FRAMES = 500;
+static const VkDeviceSize UPLOAD_STRESS_CHUNK_SIZE = 1024 * 1024;
+
+// one simulation invocation per particle, and vkCmdDispatch takes at most 65535 workgroups
+static const uint32_t PARTICLES_MAX = 65535 * ParticleSimulation::WORKGROUP_SIZE;
+// a fixed step, so both queue modes simulate the same orbits
+static const float PARTICLE_TIME_STEP = 1.0f / 60.0f;
+static const uint32_t BINDLESS_TEXTURE_CAPACITY = 1024;
+static const uint32_t BINDLESS_BUFFER_CAPACITY = 1024;
+static const uint32_t BINDLESS_TEXTURE_COUNT = 8;
+static const uint32_t BINDLESS_TEXTURE_SIZE = 64;
+static const uint32_t BINDLESS_MATERIAL_COUNT = 16;
+
+// the whole text as an unsigned decimal; "abc", "-1" and values past uint32_t are rejected
+static bool parseCount(const std::string& arg, const char* text, uint32_t& value) {
+    const char* end = text + std::char_traits<char>::length(text);
+    auto [next, error] = std::from_chars(text, end, value);
+
+    if (error != std::errc() || next != end) {
+        std::cerr << "Invalid value '" << text << "' for " << arg << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--frames-in-flight" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.framesInFlight)) {
+                return false;
+            }
+        } else if (arg == "--benchmark-frames" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.benchmarkFrames)) {
+                return false;
+            }
+        } else if (arg == "--benchmark-output" && i + 1 < argc) {
+            options.benchmarkOutput = argv[++i];
+        } else if (arg == "--allocator-stress" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.allocatorStressBuffers)) {
+                return false;
+            }
+        } else if (arg == "--no-pipeline-cache") {
+            options.usePipelineCache = false;
+        } else if (arg == "--resize-storm" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.resizeStormFrames)) {
+                return false;
+            }
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--capture-every" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.captureEvery)) {
+                return false;
+            }
+        } else if (arg == "--capture-dir" && i + 1 < argc) {
+            options.captureDirectory = argv[++i];
+        } else if (arg == "--gpu-profile") {
+            options.gpuProfile = true;
+        } else if (arg == "--gpu-trace" && i + 1 < argc) {
+            options.gpuProfile = true;
+            options.gpuTracePath = argv[++i];
+        } else if (arg == "--record-threads" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.recordThreads)) {
+                return false;
+            }
+        } else if (arg == "--draws" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.draws)) {
+                return false;
+            }
+        } else if (arg == "--gpu-culling" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.gpuCullingObjects)) {
+                return false;
+            }
+        } else if (arg == "--instances" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.instances)) {
+                return false;
+            }
+        } else if (arg == "--bindless") {
+            options.bindless = true;
+        } else if (arg == "--dynamic-rendering") {
+            options.dynamicRendering = true;
+        } else if (arg == "--no-transfer-queue") {
+            options.useTransferQueue = false;
+        } else if (arg == "--upload-stress" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.uploadStressMegabytes)) {
+                return false;
+            }
+        } else if (arg == "--particles" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.particles)) {
+                return false;
+            }
+        } else if (arg == "--no-async-compute") {
+            options.useAsyncCompute = false;
+        } else if (arg == "--fast-start") {
+            options.fastStart = true;
+        } else if (arg == "--unoptimized-shaders") {
+            options.useUnoptimizedShaders = true;
+        } else if (arg == "--shader-files") {
+            options.useShaderFiles = true;
+        } else if (arg == "--hot-reload") {
+            options.hotReload = true;
+        } else if (arg == "--pipeline-variants" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.pipelineVariants)) {
+                return false;
+            }
+        } else if (arg == "--variant-threads" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], options.variantThreads)) {
+                return false;
+            }
+        } else if (arg == "--no-pipeline-library") {
+            options.usePipelineLibrary = false;
+        } else if (arg == "--instance-stress") {
+            options.instances = INSTANCE_STRESS_INSTANCES;
+
+            if (options.benchmarkFrames == 0) {
+                options.benchmarkFrames = INSTANCE_STRESS_FRAMES;
+            }
+        } else {
+            std::cerr << "Unknown argument '" << arg << "'" << std::endl;
+            return false;
+        }
+    }
+
+    if (options.framesInFlight < 1) {
+        std::cerr << "--frames-in-flight must be at least 1" << std::endl;
+        return false;
+    }
+
+    if (options.framesInFlight > 16) {
+        std::cerr << "--frames-in-flight must be at most 16" << std::endl;
+        return false;
+    }
+
+    if (options.recordThreads > 64) {
+        std::cerr << "--record-threads must be at most 64" << std::endl;
+        return false;
+    }
+
+    if (options.gpuCullingObjects > GPU_CULLING_MAX_OBJECTS) {
+        std::cerr << "--gpu-culling must be at most " << GPU_CULLING_MAX_OBJECTS << std::endl;
+        return false;
+    }
+
+    // the culled scene is a single indirect draw, there is nothing to split over threads
+    if (options.gpuCullingObjects > 0 && options.recordThreads > 0) {
+        std::cerr << "--gpu-culling cannot be combined with --record-threads" << std::endl;
+        return false;
+    }
+
+    if (options.gpuCullingObjects > 0 && options.instances > 0) {
+        std::cerr << "--gpu-culling draws its own instances and cannot be combined with --instances" << std::endl;
+        return false;
+    }
 
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (options.particles > PARTICLES_MAX) {
+        std::cerr << "--particles must be at most " << PARTICLES_MAX << std::endl;
+        return false;
+    }
+
+    // the particles are their own scene, drawn with one instanced draw
+    if (options.particles > 0 && (options.gpuCullingObjects > 0 || options.instances > 0 || options.recordThreads > 0)) {
+        std::cerr << "--particles cannot be combined with --gpu-culling, --instances or --record-threads" << std::endl;
+        return false;
+    }
+
+    // bindless resources are only read by the plain quads; the instanced and scene pipelines draw without them
+    if (options.bindless && (options.instances > 0 || options.gpuCullingObjects > 0 || options.particles > 0)) {
+        std::cerr << "--bindless cannot be combined with --instances, --gpu-culling or --particles" << std::endl;
+        return false;
+    }
 
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    // the variants are of the plain draw pipeline, the other scenes draw with pipelines of their own
+    if (options.pipelineVariants > 0 && (options.gpuCullingObjects > 0 || options.instances > 0 || options.particles > 0 || options.bindless)) {
+        std::cerr << "--pipeline-variants cannot be combined with --gpu-culling, --instances, --particles or --bindless" << std::endl;
+        return false;
+    }
 
-    VkBufferCopy copyRegion{};
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+    // only the graphics pipeline is rebuilt; the other scenes would keep drawing with the shaders they started with
+    if (options.hotReload && (options.gpuCullingObjects > 0 || options.instances > 0 || options.particles > 0 || options.bindless || options.pipelineVariants > 0)) {
+        std::cerr << "--hot-reload rebuilds the plain quad pipeline only and cannot be combined with --gpu-culling, --instances, --particles, --bindless or --pipeline-variants" << std::endl;
+        return false;
+    }
 
-    vkEndCommandBuffer(commandBuffer);
+    if (options.variantThreads > 64) {
+        std::cerr << "--variant-threads must be at most 64" << std::endl;
+        return false;
+    }
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
+    if (options.headless && options.resizeStormFrames > 0) {
+        std::cerr << "--resize-storm needs a window and cannot be combined with --headless" << std::endl;
+        return false;
+    }
 
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
+    // there is no window to close, so a headless run always renders a fixed number of frames
+    if (options.headless && options.benchmarkFrames == 0) {
+        options.benchmarkFrames = HEADLESS_DEFAULT_FRAMES;
+    }
 
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    return true;
 }
 
-int main() {
-    std::cout << "Initializing GLFW..." << std::endl;
+int main(int argc, char** argv) {
+    // launch to first present, phase by phase
+    StartupProfiler startupProfiler;
 
-    if (!glfwInit()) {
-        std::cerr << "Could not load GLTF" << std::endl;
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
         return 1;
     }
 
+    // fast start: std::endl no longer waits for the terminal
+    std::unique_ptr<AsyncLog> asyncLog;
+
+    if (options.fastStart) {
+        asyncLog = std::make_unique<AsyncLog>(std::cout);
+    }
+
+    startupProfiler.beginPhase("window");
+
     const auto WINDOW_WIDTH = 1024;
     const auto WINDOW_HEIGHT = 768;
 
-    std::cout << "Creating GLFW window..." << std::endl;
+    // headless runs don't create a window, so they work without a display
+    GLFWwindow *window = nullptr;
+
+    if (!options.headless) {
+        std::cout << "Initializing GLFW..." << std::endl;
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        if (!glfwInit()) {
+            std::cerr << "Could not load GLTF" << std::endl;
+            return 1;
+        }
 
-    GLFWwindow *window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan with GLFW", NULL, NULL);
+        std::cout << "Creating GLFW window..." << std::endl;
 
-    if (!window) {
-        std::cerr << "Could not create GLFW window" << std::endl;
-        return 1;
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Vulkan with GLFW", NULL, NULL);
+
+        if (!window) {
+            std::cerr << "Could not create GLFW window" << std::endl;
+            return 1;
+        }
     }
 
+    startupProfiler.beginPhase("layers");
+
     std::cout << "Check Vulkan validation layers..." << std::endl;
 
-    uint32_t layerCount;
-    vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+    uint32_t layerCount = 0;
+    std::vector<VkLayerProperties> availableLayers;
+    std::vector<const char *> requestedValidationLayers;
 
-    std::vector<VkLayerProperties> availableLayers(layerCount);
-    vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+    // fast start: the layers are not enumerated, which reads every layer manifest, and validation is not loaded
+    if (options.fastStart) {
+        std::cout << "Skipping validation layers (fast start)" << std::endl;
+    } else {
+        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+        availableLayers.resize(layerCount);
+        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+        requestedValidationLayers.push_back("VK_LAYER_KHRONOS_validation");
+    }
 
-    const std::vector<const char *> validationLayers = {
-        "VK_LAYER_KHRONOS_validation"};
+    std::vector<const char *> validationLayers;
 
-    for (const char *layerName : validationLayers) {
+    for (const char *layerName : requestedValidationLayers) {
         bool layerFound = false;
 
         for (const auto &layerProperties : availableLayers) {
@@ -378,12 +814,19 @@ int main() {
             }
         }
 
-        if (!layerFound) {
+        if (layerFound) {
+            validationLayers.push_back(layerName);
+        } else if (options.headless) {
+            // render farm and CI machines usually come without the SDK layers
+            std::cerr << "Could not find requested validation layer '" << layerName << "', continuing without it" << std::endl;
+        } else {
             std::cerr << "Could not find requested validation layer '" << layerName << "'" << std::endl;
             return 1;
         }
     }
 
+    startupProfiler.beginPhase("instance");
+
     std::cout << "Initializing Vulkan..." << std::endl;
 
     // initialize Vulkan
@@ -393,24 +836,27 @@ int main() {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    // timeline semaphores are core in Vulkan 1.2, dynamic rendering and synchronization2 in Vulkan 1.3
+    appInfo.apiVersion = options.dynamicRendering ? VK_API_VERSION_1_3 : VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo instanceCreateInfo{};
     instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     instanceCreateInfo.pApplicationInfo = &appInfo;
 
-    uint32_t glfwExtensionCount = 0;
+    std::vector<const char *> requiredExtensions;
 
-    const char **glfwExtensions;
+    if (!options.headless) {
+        uint32_t glfwExtensionCount = 0;
 
-    std::cout << "Obtaining required Vulkan extensions via GLFW..." << std::endl;
+        const char **glfwExtensions;
 
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        std::cout << "Obtaining required Vulkan extensions via GLFW..." << std::endl;
 
-    std::vector<const char *> requiredExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-    for (uint32_t i = 0; i < glfwExtensionCount; i++) {
-        requiredExtensions.emplace_back(glfwExtensions[i]);
+        for (uint32_t i = 0; i < glfwExtensionCount; i++) {
+            requiredExtensions.emplace_back(glfwExtensions[i]);
+        }
     }
 
 #ifdef __APPLE__
@@ -418,6 +864,11 @@ int main() {
     requiredExtensions.emplace_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 
     instanceCreateInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+#else
+    // bindless descriptors query their features through vkGetPhysicalDeviceFeatures2KHR
+    if (options.bindless) {
+        requiredExtensions.emplace_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
 #endif
 
     instanceCreateInfo.enabledExtensionCount = (uint32_t)requiredExtensions.size();
@@ -438,17 +889,22 @@ int main() {
     }
 
     // window surface
+    startupProfiler.beginPhase("surface");
 
-    std::cout << "Creating window surface..." << std::endl;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
 
-    VkSurfaceKHR surface;
+    if (!options.headless) {
+        std::cout << "Creating window surface..." << std::endl;
 
-    if (glfwCreateWindowSurface(instance, window, NULL, &surface)) {
-        std::cerr << "Failed to create GLFW window surface" << std::endl;
-        return 1;
+        if (glfwCreateWindowSurface(instance, window, NULL, &surface)) {
+            std::cerr << "Failed to create GLFW window surface" << std::endl;
+            return 1;
+        }
     }
 
     // physical device
+    startupProfiler.beginPhase("physical device");
+
     std::cout << "Obtaining physical devices..." << std::endl;
 
     uint32_t deviceCount = 0;
@@ -478,7 +934,43 @@ int main() {
         return 1;
     }
 
+    if (!TimelineScheduler::isSupported(physicalDevice)) {
+        std::cerr << "Device does not support Vulkan 1.2 timeline semaphores" << std::endl;
+        return 1;
+    }
+
+    if (options.bindless && !BindlessDescriptors::isSupported(instance, physicalDevice, BINDLESS_TEXTURE_CAPACITY, BINDLESS_BUFFER_CAPACITY)) {
+        std::cerr << "Device does not support the descriptor indexing features bindless descriptors need" << std::endl;
+        return 1;
+    }
+
+    if (options.dynamicRendering) {
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+        if (deviceProperties.apiVersion < VK_API_VERSION_1_3) {
+            std::cerr << "Device does not support Vulkan 1.3, which --dynamic-rendering needs" << std::endl;
+            return 1;
+        }
+
+        VkPhysicalDeviceVulkan13Features supportedVulkan13Features{};
+        supportedVulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+        VkPhysicalDeviceFeatures2 supportedFeatures2{};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &supportedVulkan13Features;
+
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+
+        if (!supportedVulkan13Features.dynamicRendering || !supportedVulkan13Features.synchronization2) {
+            std::cerr << "Device does not support dynamicRendering and synchronization2, which --dynamic-rendering needs" << std::endl;
+            return 1;
+        }
+    }
+
     // logical device
+    startupProfiler.beginPhase("device");
+
     auto queueFamilies = findQueueFamilies(physicalDevice, surface);
 
     if (queueFamilies.graphicsQueueFamilyIndex < 0) {
@@ -486,13 +978,31 @@ int main() {
         return 1;
     }
 
-    if (queueFamilies.presentationQueueFamilyIndex < 0) {
+    if (!options.headless && queueFamilies.presentationQueueFamilyIndex < 0) {
         std::cerr << "Failed to obtain compatible presentation queue" << std::endl;
         return 1;
     }
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = { (uint32_t)queueFamilies.graphicsQueueFamilyIndex, (uint32_t)queueFamilies.presentationQueueFamilyIndex };
+    std::set<uint32_t> uniqueQueueFamilies = { (uint32_t)queueFamilies.graphicsQueueFamilyIndex };
+
+    if (!options.headless) {
+        uniqueQueueFamilies.insert((uint32_t)queueFamilies.presentationQueueFamilyIndex);
+    }
+
+    // uploads go through the dedicated transfer family when there is one
+    bool useTransferQueue = options.useTransferQueue && queueFamilies.transferQueueFamilyIndex > -1;
+
+    if (useTransferQueue) {
+        uniqueQueueFamilies.insert((uint32_t)queueFamilies.transferQueueFamilyIndex);
+    }
+
+    // and compute passes through the async compute family
+    bool useComputeQueue = options.particles > 0 && options.useAsyncCompute && queueFamilies.computeQueueFamilyIndex > -1;
+
+    if (useComputeQueue) {
+        uniqueQueueFamilies.insert((uint32_t)queueFamilies.computeQueueFamilyIndex);
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -514,132 +1024,188 @@ int main() {
 
     deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
-    std::vector<const char *> logicalDeviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    std::vector<const char *> logicalDeviceExtensions;
+
+    if (!options.headless) {
+        logicalDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
 #ifdef __APPLE__
     logicalDeviceExtensions.push_back("VK_KHR_portability_subset");
 #endif
 
-    deviceCreateInfo.enabledExtensionCount = (uint32_t)logicalDeviceExtensions.size();
-    deviceCreateInfo.ppEnabledExtensionNames = logicalDeviceExtensions.data();
+    // GPU culling: firstInstance selects the object, and the draws are either counted on the GPU or issued as one
+    // multi-draw with the culled objects left at zero instances
+    bool hasDrawIndirectCount = false;
 
-    deviceCreateInfo.enabledLayerCount = 0;
+    if (options.gpuCullingObjects > 0) {
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
 
-    VkDevice device;
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
 
-    std::cout << "Creating logical device..." << std::endl;
+        hasDrawIndirectCount = isDeviceExtensionSupported(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 
-    if (vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device) != VK_SUCCESS) {
-        std::cerr << "Failed to create logical device" << std::endl;
-        return 1;
-    }
+        if (!supportedFeatures.drawIndirectFirstInstance) {
+            std::cerr << "Device does not support drawIndirectFirstInstance, which GPU culling needs" << std::endl;
+            return 1;
+        }
 
-    std::cout << "Obtaining queue..." << std::endl;
+        if (!hasDrawIndirectCount && !supportedFeatures.multiDrawIndirect) {
+            std::cerr << "Device supports neither " << VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME << " nor multiDrawIndirect, which GPU culling needs" << std::endl;
+            return 1;
+        }
 
-    VkQueue graphicsQueue;
-    vkGetDeviceQueue(device, (uint32_t) queueFamilies.graphicsQueueFamilyIndex, 0, &graphicsQueue);
+        if (options.gpuCullingObjects > deviceProperties.limits.maxDrawIndirectCount) {
+            std::cerr << "Device supports at most " << deviceProperties.limits.maxDrawIndirectCount << " indirect draws, --gpu-culling asks for " << options.gpuCullingObjects << std::endl;
+            return 1;
+        }
 
-    VkQueue presentQueue;
-    vkGetDeviceQueue(device, (uint32_t) queueFamilies.presentationQueueFamilyIndex, 0, &presentQueue);
+        deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
 
-    // swap chain
-    int framebufferWidth, framebufferHeight;
-    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        if (hasDrawIndirectCount) {
+            logicalDeviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+    }
 
-    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, surface);
+    // every submission signals the timeline
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = TimelineScheduler::getRequiredFeatures();
+    deviceCreateInfo.pNext = &timelineSemaphoreFeatures;
 
-    VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
-    VkExtent2D swapChainExtent = chooseSwapExtent(swapChainSupport.capabilities, framebufferWidth, framebufferHeight);
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = BindlessDescriptors::getRequiredFeatures();
 
-    VkFormat swapChainImageFormat = surfaceFormat.format;
+    if (options.bindless) {
+        const auto& bindlessExtensions = BindlessDescriptors::getRequiredExtensions();
+        logicalDeviceExtensions.insert(logicalDeviceExtensions.end(), bindlessExtensions.begin(), bindlessExtensions.end());
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        BindlessDescriptors::enableRequiredCoreFeatures(deviceFeatures);
 
-    if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-        imageCount = swapChainSupport.capabilities.maxImageCount;
+        descriptorIndexingFeatures.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+        deviceCreateInfo.pNext = &descriptorIndexingFeatures;
     }
 
-    VkSwapchainCreateInfoKHR swapChainCreateInfo{};
-    swapChainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    swapChainCreateInfo.surface = surface;
+    VkPhysicalDeviceVulkan13Features vulkan13Features{};
+    vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    vulkan13Features.dynamicRendering = VK_TRUE;
+    vulkan13Features.synchronization2 = VK_TRUE;
 
-    swapChainCreateInfo.minImageCount = imageCount;
-    swapChainCreateInfo.imageFormat = surfaceFormat.format;
-    swapChainCreateInfo.imageColorSpace = surfaceFormat.colorSpace;
-    swapChainCreateInfo.imageExtent = swapChainExtent;
-    swapChainCreateInfo.imageArrayLayers = 1;
-    swapChainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (options.dynamicRendering) {
+        vulkan13Features.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+        deviceCreateInfo.pNext = &vulkan13Features;
+    }
 
-    uint32_t queueFamilyIndices[] = {(uint32_t) queueFamilies.graphicsQueueFamilyIndex, (uint32_t) queueFamilies.presentationQueueFamilyIndex};
+    // pipeline variants are linked from graphics pipeline libraries where the device has them
+    bool usePipelineLibrary = options.pipelineVariants > 0 && options.usePipelineLibrary && PipelineVariantCache::isGraphicsPipelineLibrarySupported(physicalDevice);
 
-    if (queueFamilies.graphicsQueueFamilyIndex != queueFamilies.presentationQueueFamilyIndex) {
-        swapChainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-        swapChainCreateInfo.queueFamilyIndexCount = 2;
-        swapChainCreateInfo.pQueueFamilyIndices = queueFamilyIndices;
-    } else {
-        swapChainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        swapChainCreateInfo.queueFamilyIndexCount = 0; // Optional
-        swapChainCreateInfo.pQueueFamilyIndices = nullptr; // Optional
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures = PipelineVariantCache::getGraphicsPipelineLibraryFeatures();
+
+    if (usePipelineLibrary) {
+        const auto& pipelineLibraryExtensions = PipelineVariantCache::getGraphicsPipelineLibraryExtensions();
+        logicalDeviceExtensions.insert(logicalDeviceExtensions.end(), pipelineLibraryExtensions.begin(), pipelineLibraryExtensions.end());
+
+        pipelineLibraryFeatures.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+        deviceCreateInfo.pNext = &pipelineLibraryFeatures;
     }
 
-    swapChainCreateInfo.preTransform = swapChainSupport.capabilities.currentTransform;
-    swapChainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    deviceCreateInfo.enabledExtensionCount = (uint32_t)logicalDeviceExtensions.size();
+    deviceCreateInfo.ppEnabledExtensionNames = logicalDeviceExtensions.data();
 
-    swapChainCreateInfo.presentMode = presentMode;
-    swapChainCreateInfo.clipped = VK_TRUE;
-    swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+    deviceCreateInfo.enabledLayerCount = 0;
 
-    VkSwapchainKHR swapChain;
+    VkDevice device;
 
-    if (vkCreateSwapchainKHR(device, &swapChainCreateInfo, nullptr, &swapChain) != VK_SUCCESS) {
-        std::cerr << "Failed to create swap chain" << std::endl;
+    std::cout << "Creating logical device..." << std::endl;
+
+    if (vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device) != VK_SUCCESS) {
+        std::cerr << "Failed to create logical device" << std::endl;
         return 1;
     }
 
-    // swap chain images and image views
+    std::cout << "Obtaining queue..." << std::endl;
 
-    std::vector<VkImage> swapChainImages;
-    vkGetSwapchainImagesKHR(device, swapChain, &imageCount, nullptr);
+    VkQueue graphicsQueue;
+    vkGetDeviceQueue(device, (uint32_t) queueFamilies.graphicsQueueFamilyIndex, 0, &graphicsQueue);
 
-    swapChainImages.resize(imageCount);
-    vkGetSwapchainImagesKHR(device, swapChain, &imageCount, swapChainImages.data());
+    VkQueue presentQueue = VK_NULL_HANDLE;
 
-    std::vector<VkImageView> swapChainImageViews;
-    swapChainImageViews.resize(swapChainImages.size());
+    if (!options.headless) {
+        vkGetDeviceQueue(device, (uint32_t) queueFamilies.presentationQueueFamilyIndex, 0, &presentQueue);
+    }
 
-    for (size_t i = 0; i < swapChainImages.size(); i++) {
-        VkImageViewCreateInfo swapChainImageCreateInfo{};
-        swapChainImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        swapChainImageCreateInfo.image = swapChainImages[i];
+    // frames and upload batches are all submitted to the graphics queue, each signaling the next timeline value
+    auto timeline = std::make_unique<TimelineScheduler>(device);
 
-        swapChainImageCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        swapChainImageCreateInfo.format = swapChainImageFormat;
+    // the transfer queue signals a timeline of its own, which the graphics queue waits on
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    std::unique_ptr<TimelineScheduler> transferTimeline;
 
-        swapChainImageCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        swapChainImageCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        swapChainImageCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        swapChainImageCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    if (useTransferQueue) {
+        vkGetDeviceQueue(device, (uint32_t) queueFamilies.transferQueueFamilyIndex, 0, &transferQueue);
+        transferTimeline = std::make_unique<TimelineScheduler>(device);
+    }
 
-        swapChainImageCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        swapChainImageCreateInfo.subresourceRange.baseMipLevel = 0;
-        swapChainImageCreateInfo.subresourceRange.levelCount = 1;
-        swapChainImageCreateInfo.subresourceRange.baseArrayLayer = 0;
-        swapChainImageCreateInfo.subresourceRange.layerCount = 1;
+    // so does the compute queue
+    VkQueue computeQueue = VK_NULL_HANDLE;
+    std::unique_ptr<TimelineScheduler> computeTimeline;
 
-        if (vkCreateImageView(device, &swapChainImageCreateInfo, nullptr, &swapChainImageViews[i]) != VK_SUCCESS) {
-            std::cerr << "Failed to create swap chain image views" << std::endl;
-            return 1;
-        }
+    if (useComputeQueue) {
+        vkGetDeviceQueue(device, (uint32_t) queueFamilies.computeQueueFamilyIndex, 0, &computeQueue);
+        computeTimeline = std::make_unique<TimelineScheduler>(device);
+    }
+
+    // dynamic rendering: core 1.3 commands, looked up on the device like the other optional entry points
+    PFN_vkCmdBeginRendering cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRendering cmdEndRendering = nullptr;
+    PFN_vkCmdPipelineBarrier2 cmdPipelineBarrier2 = nullptr;
+
+    if (options.dynamicRendering) {
+        cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRendering>(vkGetDeviceProcAddr(device, "vkCmdBeginRendering"));
+        cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRendering>(vkGetDeviceProcAddr(device, "vkCmdEndRendering"));
+        cmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2>(vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2"));
+
+        std::cout << "[dynamic rendering] rendering without a render pass or framebuffers" << std::endl;
+    }
+
+    // swap chain format and present mode; the swap chain itself is created once the render pass exists
+    VkSurfaceFormatKHR surfaceFormat{};
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+
+    if (!options.headless) {
+        SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, surface);
+
+        surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, options.benchmarkFrames > 0 || options.resizeStormFrames > 0);
+    }
+
+    // offscreen targets use a format every implementation can render to
+    VkFormat swapChainImageFormat = options.headless ? HEADLESS_FORMAT : surfaceFormat.format;
+
+    auto allocator = std::make_unique<DeviceMemoryAllocator>(device, physicalDevice);
+
+    // per-draw uniforms, one block per draw and frame slot
+    auto uniformRing = std::make_unique<UniformRing>(device, physicalDevice, *allocator, sizeof(DrawUniforms), std::max(options.draws, 1u), VK_SHADER_STAGE_VERTEX_BIT, options.framesInFlight);
+
+    // bindless textures and materials, indexed with push constants
+    std::unique_ptr<BindlessDescriptors> bindlessDescriptors;
+
+    if (options.bindless) {
+        bindlessDescriptors = std::make_unique<BindlessDescriptors>(device, VK_SHADER_STAGE_FRAGMENT_BIT, BINDLESS_TEXTURE_CAPACITY, BINDLESS_BUFFER_CAPACITY, options.framesInFlight);
     }
 
     // shaders
-    auto vertShaderCode = readFile("shaders/shader_vert.spv");
-    auto fragShaderCode = readFile("shaders/shader_frag.spv");
+    startupProfiler.beginPhase("shaders");
+
+    auto vertShaderCode = readShader(options, "shader_vert.spv");
+    auto fragShaderCode = readShader(options, "shader_frag.spv");
 
-    VkShaderModule vertShaderModule = createShaderModule(device, vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(device, fragShaderCode);
+    // what the shaders expect from the pipeline, checked against the C++ side as the pipelines are set up
+    ShaderReflection vertShaderReflection = ShaderReflection::reflect(vertShaderCode.getCode());
+    ShaderReflection fragShaderReflection = ShaderReflection::reflect(fragShaderCode.getCode());
+
+    VkShaderModule vertShaderModule = createShaderModule(device, vertShaderCode.getCode());
+    VkShaderModule fragShaderModule = createShaderModule(device, fragShaderCode.getCode());
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -666,6 +1232,8 @@ int main() {
     vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
+    validateVertexInput(vertShaderReflection, { &bindingDescription, 1 }, attributeDescriptions, "shader.vert");
+
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -727,7 +1295,8 @@ int main() {
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // offscreen targets are only ever read back by transfers
+    colorAttachment.finalLayout = options.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -739,34 +1308,70 @@ int main() {
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
 
-    VkRenderPass renderPass;
+    // dynamic rendering begins rendering straight on the image views, without a render pass or framebuffers
+    VkRenderPass renderPass = VK_NULL_HANDLE;
     VkPipelineLayout pipelineLayout;
 
+    // frame captures copy the color attachment right after the render pass
+    VkSubpassDependency captureDependency{};
+    captureDependency.srcSubpass = 0;
+    captureDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    captureDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    captureDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    captureDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    captureDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.attachmentCount = 1;
     renderPassInfo.pAttachments = &colorAttachment;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &captureDependency;
 
-    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+    if (!options.dynamicRendering && vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
         std::cerr << "Failed to create render pass" << std::endl;
         return 1;
     }
 
     VkPipeline graphicsPipeline;
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0; // Optional
-    pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+    // layouts are made from what the shaders declare and shared by all pipelines that declare the same
+    auto pipelineLayoutCache = std::make_unique<PipelineLayoutCache>(device);
 
-    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
+    // the draw pipelines share one layout, so it covers the shaders of all of them
+    ShaderReflection drawShaderReflection = vertShaderReflection;
+    drawShaderReflection.merge(fragShaderReflection);
+
+    ShaderBinary instancedVertShaderCode;
+    ShaderReflection instancedVertShaderReflection;
+
+    if (options.instances > 0 || options.particles > 0) {
+        instancedVertShaderCode = readShader(options, "instanced_vert.spv");
+        instancedVertShaderReflection = ShaderReflection::reflect(instancedVertShaderCode.getCode());
+        drawShaderReflection.merge(instancedVertShaderReflection);
     }
 
+    // set 0: per-draw uniforms, set 1: bindless resources; both layouts belong to the modules that allocate the sets
+    std::vector<PipelineLayoutCache::ExternalSetLayout> drawSetLayouts = {
+        { 0, uniformRing->getDescriptorSetLayout(), uniformRing->getDescriptorSetLayoutBindings() }
+    };
+
+    ShaderBinary bindlessFragShaderCode;
+
+    if (bindlessDescriptors) {
+        bindlessFragShaderCode = readShader(options, "bindless_frag.spv");
+        drawShaderReflection.merge(ShaderReflection::reflect(bindlessFragShaderCode.getCode()));
+        drawSetLayouts.push_back({ 1, bindlessDescriptors->getDescriptorSetLayout(), bindlessDescriptors->getDescriptorSetLayoutBindings() });
+    }
+
+    validatePushConstants(drawShaderReflection, sizeof(DrawPushConstants), "draw pipelines");
+    pipelineLayout = pipelineLayoutCache->getPipelineLayout(drawShaderReflection, drawSetLayouts, "draw pipelines");
+
+    // the part of DrawPushConstants the shaders read, for every stage that reads some of it
+    VkPushConstantRange drawPushConstantRange = drawShaderReflection.pushConstantRange;
+
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount = 2;
@@ -783,39 +1388,286 @@ int main() {
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    // without a render pass the pipeline is told the attachment formats instead
+    VkPipelineRenderingCreateInfo pipelineRenderingInfo{};
+    pipelineRenderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    pipelineRenderingInfo.colorAttachmentCount = 1;
+    pipelineRenderingInfo.pColorAttachmentFormats = &swapChainImageFormat;
+
+    if (options.dynamicRendering) {
+        pipelineInfo.pNext = &pipelineRenderingInfo;
+    }
+
+    // pipeline cache
+    startupProfiler.beginPhase("pipelines");
+
+    auto pipelineCache = std::make_unique<PersistentPipelineCache>(device, physicalDevice, getExecutableDirectory(argv[0]) / "pipeline_cache.bin", options.usePipelineCache);
+
+    auto pipelineCreationStart = std::chrono::steady_clock::now();
+
+    if (vkCreateGraphicsPipelines(device, pipelineCache->get(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
+    auto pipelineCreationTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pipelineCreationStart).count();
+
+    if (pipelineCache->isWarm()) {
+        std::cout << "[pipeline cache] warm: graphics pipeline created in " << pipelineCreationTime << " ms (" << pipelineCache->getLoadedSize() << " bytes loaded)" << std::endl;
+    } else {
+        std::cout << "[pipeline cache] cold (" << pipelineCache->getColdReason() << "): graphics pipeline created in " << pipelineCreationTime << " ms" << std::endl;
+    }
+
+    // GPU culling: the same quad, instanced from the object buffer and placed by a camera in push constants
+    VkPipelineLayout scenePipelineLayout = VK_NULL_HANDLE;
+    VkPipeline scenePipeline = VK_NULL_HANDLE;
+
+    if (options.gpuCullingObjects > 0) {
+        auto sceneVertShaderCode = readShader(options, "scene_vert.spv");
+        ShaderReflection sceneShaderReflection = ShaderReflection::reflect(sceneVertShaderCode.getCode());
+
+        VkShaderModule sceneVertShaderModule = createShaderModule(device, sceneVertShaderCode.getCode());
+
+        VkPipelineShaderStageCreateInfo sceneShaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+        sceneShaderStages[0].module = sceneVertShaderModule;
+
+        std::array<VkVertexInputBindingDescription, 2> sceneBindingDescriptions = { Vertex::getBindingDescription() };
+        sceneBindingDescriptions[1].binding = 1;
+        sceneBindingDescriptions[1].stride = sizeof(GpuCulling::Object);
+        sceneBindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+        std::array<VkVertexInputAttributeDescription, 3> sceneAttributeDescriptions{};
+        std::copy(attributeDescriptions.begin(), attributeDescriptions.end(), sceneAttributeDescriptions.begin());
+        sceneAttributeDescriptions[2].binding = 1;
+        sceneAttributeDescriptions[2].location = 2;
+        sceneAttributeDescriptions[2].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        sceneAttributeDescriptions[2].offset = 0;
+
+        validateVertexInput(sceneShaderReflection, sceneBindingDescriptions, sceneAttributeDescriptions, "scene.vert");
+        validatePushConstants(sceneShaderReflection, sizeof(glm::vec4), "scene.vert");
+
+        sceneShaderReflection.merge(fragShaderReflection);
+        scenePipelineLayout = pipelineLayoutCache->getPipelineLayout(sceneShaderReflection, {}, "scene pipeline");
+
+        VkPipelineVertexInputStateCreateInfo sceneVertexInputInfo = vertexInputInfo;
+        sceneVertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(sceneBindingDescriptions.size());
+        sceneVertexInputInfo.pVertexBindingDescriptions = sceneBindingDescriptions.data();
+        sceneVertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(sceneAttributeDescriptions.size());
+        sceneVertexInputInfo.pVertexAttributeDescriptions = sceneAttributeDescriptions.data();
+
+        VkGraphicsPipelineCreateInfo scenePipelineInfo = pipelineInfo;
+        scenePipelineInfo.pStages = sceneShaderStages;
+        scenePipelineInfo.pVertexInputState = &sceneVertexInputInfo;
+        scenePipelineInfo.layout = scenePipelineLayout;
+
+        VkResult scenePipelineResult = vkCreateGraphicsPipelines(device, pipelineCache->get(), 1, &scenePipelineInfo, nullptr, &scenePipeline);
+
+        vkDestroyShaderModule(device, sceneVertShaderModule, nullptr);
+
+        if (scenePipelineResult != VK_SUCCESS) {
+            throw std::runtime_error("failed to create scene pipeline!");
+        }
+    }
+
+    // instancing: the quad pipeline with a second, per-instance vertex binding; the particles are drawn with it too
+    VkPipeline instancedPipeline = VK_NULL_HANDLE;
+
+    if (options.instances > 0 || options.particles > 0) {
+        VkShaderModule instancedVertShaderModule = createShaderModule(device, instancedVertShaderCode.getCode());
+
+        VkPipelineShaderStageCreateInfo instancedShaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+        instancedShaderStages[0].module = instancedVertShaderModule;
+
+        std::array<VkVertexInputBindingDescription, 2> instancedBindingDescriptions = { Vertex::getBindingDescription(), InstanceData::getBindingDescription() };
+
+        auto instanceAttributeDescriptions = InstanceData::getAttributeDescriptions();
+        std::array<VkVertexInputAttributeDescription, 4> instancedAttributeDescriptions{};
+        std::copy(attributeDescriptions.begin(), attributeDescriptions.end(), instancedAttributeDescriptions.begin());
+        std::copy(instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end(), instancedAttributeDescriptions.begin() + attributeDescriptions.size());
+
+        validateVertexInput(instancedVertShaderReflection, instancedBindingDescriptions, instancedAttributeDescriptions, "instanced.vert");
+
+        VkPipelineVertexInputStateCreateInfo instancedVertexInputInfo = vertexInputInfo;
+        instancedVertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(instancedBindingDescriptions.size());
+        instancedVertexInputInfo.pVertexBindingDescriptions = instancedBindingDescriptions.data();
+        instancedVertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(instancedAttributeDescriptions.size());
+        instancedVertexInputInfo.pVertexAttributeDescriptions = instancedAttributeDescriptions.data();
+
+        VkGraphicsPipelineCreateInfo instancedPipelineInfo = pipelineInfo;
+        instancedPipelineInfo.pStages = instancedShaderStages;
+        instancedPipelineInfo.pVertexInputState = &instancedVertexInputInfo;
+
+        VkResult instancedPipelineResult = vkCreateGraphicsPipelines(device, pipelineCache->get(), 1, &instancedPipelineInfo, nullptr, &instancedPipeline);
+
+        vkDestroyShaderModule(device, instancedVertShaderModule, nullptr);
+
+        if (instancedPipelineResult != VK_SUCCESS) {
+            throw std::runtime_error("failed to create instanced pipeline!");
+        }
+    }
+
+    // bindless: the quad pipeline with a fragment shader that samples the draw's texture and material
+    VkPipeline bindlessPipeline = VK_NULL_HANDLE;
+
+    if (options.bindless) {
+        VkShaderModule bindlessFragShaderModule = createShaderModule(device, bindlessFragShaderCode.getCode());
+
+        VkPipelineShaderStageCreateInfo bindlessShaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+        bindlessShaderStages[1].module = bindlessFragShaderModule;
+
+        VkGraphicsPipelineCreateInfo bindlessPipelineInfo = pipelineInfo;
+        bindlessPipelineInfo.pStages = bindlessShaderStages;
+
+        VkResult bindlessPipelineResult = vkCreateGraphicsPipelines(device, pipelineCache->get(), 1, &bindlessPipelineInfo, nullptr, &bindlessPipeline);
+
+        vkDestroyShaderModule(device, bindlessFragShaderModule, nullptr);
+
+        if (bindlessPipelineResult != VK_SUCCESS) {
+            throw std::runtime_error("failed to create bindless pipeline!");
+        }
+    }
+
+    std::cout << "[layouts] " << pipelineLayoutCache->getPipelineLayoutCount() << " pipeline layout(s), " << pipelineLayoutCache->getDescriptorSetLayoutCount()
+              << " generated descriptor set layout(s), " << pipelineLayoutCache->getHitCount() << " reused" << std::endl;
+
+    // hot reload: shader.vert and shader.frag are recompiled from the source tree when they change and the graphics
+    // pipeline rebuilt in the background; the render loop swaps it in between frames
+    std::unique_ptr<ShaderHotReload> shaderHotReload;
+
+    if (options.hotReload) {
+        if (!std::filesystem::is_directory(VULKAN_GLFW_SHADER_SOURCE_DIR)) {
+            std::cerr << "Failed to enable hot reload: " << VULKAN_GLFW_SHADER_SOURCE_DIR << " does not exist" << std::endl;
+            return 1;
+        }
+
+        // the bindings of every set in the pipeline layout, as it was created at startup
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> drawSetBindings(std::max(drawShaderReflection.getSetCount(), static_cast<uint32_t>(drawSetLayouts.size())));
+
+        for (uint32_t set = 0; set < drawSetBindings.size(); set++) {
+            auto external = std::find_if(drawSetLayouts.begin(), drawSetLayouts.end(), [&](const PipelineLayoutCache::ExternalSetLayout& e) { return e.set == set; });
+            drawSetBindings[set] = external != drawSetLayouts.end() ? external->bindings : drawShaderReflection.getSetLayoutBindings(set);
+        }
+
+        // everything pipelineInfo points to lives until the end of main
+        auto buildGraphicsPipeline = [device, pipelineInfo, cache = pipelineCache->get(), drawSetBindings, drawPushConstantRange](std::span<const VkPipelineShaderStageCreateInfo> stages, std::span<const std::vector<uint32_t>> codes) {
+            // an edited shader that no longer fits the layout or the vertex input would make creating the pipeline
+            // invalid usage rather than a failure the driver reports
+            try {
+                ShaderReflection reflection;
+
+                for (size_t i = 0; i < stages.size(); i++) {
+                    ShaderReflection stageReflection = ShaderReflection::reflect(codes[i]);
+
+                    if (stages[i].stage == VK_SHADER_STAGE_VERTEX_BIT) {
+                        const auto& vertexInput = *pipelineInfo.pVertexInputState;
+                        validateVertexInput(stageReflection, { vertexInput.pVertexBindingDescriptions, vertexInput.vertexBindingDescriptionCount }, { vertexInput.pVertexAttributeDescriptions, vertexInput.vertexAttributeDescriptionCount }, "reloaded shader.vert");
+                    }
+
+                    reflection.merge(stageReflection);
+                }
+
+                validatePushConstants(reflection, sizeof(DrawPushConstants), "reloaded shaders");
+                validatePushConstantRange(reflection, drawPushConstantRange, "reloaded shaders");
+
+                for (uint32_t set = 0; set < reflection.getSetCount(); set++) {
+                    if (set >= drawSetBindings.size() && !reflection.getSetLayoutBindings(set).empty()) {
+                        throw std::runtime_error("reloaded shaders use set " + std::to_string(set) + ", which the pipeline layout does not have!");
+                    }
+
+                    if (set < drawSetBindings.size()) {
+                        validateDescriptorSetLayout(reflection, set, drawSetBindings[set], "reloaded shaders");
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "[hot reload] " << e.what() << std::endl;
+                return static_cast<VkPipeline>(VK_NULL_HANDLE);
+            }
+
+            VkGraphicsPipelineCreateInfo reloadPipelineInfo = pipelineInfo;
+            reloadPipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+            reloadPipelineInfo.pStages = stages.data();
+
+            VkPipeline pipeline;
+
+            if (vkCreateGraphicsPipelines(device, cache, 1, &reloadPipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+                return static_cast<VkPipeline>(VK_NULL_HANDLE);
+            }
+
+            return pipeline;
+        };
+
+        std::vector<ShaderHotReload::Shader> reloadShaders = {
+            { "shader.vert", VK_SHADER_STAGE_VERTEX_BIT },
+            { "shader.frag", VK_SHADER_STAGE_FRAGMENT_BIT }
+        };
+
+        shaderHotReload = std::make_unique<ShaderHotReload>(device, VULKAN_GLFW_GLSLC, VULKAN_GLFW_SHADER_SOURCE_DIR, getExecutableDirectory(argv[0]) / "shaders" / "hot_reload", reloadShaders, buildGraphicsPipeline);
+    }
+
+    // pipeline variants: compiled on worker threads while the frames draw them with the graphics pipeline
+    std::unique_ptr<PipelineVariantCache> pipelineVariantCache;
+    std::vector<uint32_t> pipelineVariantIds;
+
+    if (options.pipelineVariants > 0) {
+        uint32_t variantThreads = options.variantThreads > 0 ? options.variantThreads : std::max(1u, std::thread::hardware_concurrency() / 2);
+        pipelineVariantCache = std::make_unique<PipelineVariantCache>(device, pipelineCache->get(), pipelineInfo, vertShaderCode.getCode(), fragShaderCode.getCode(), variantThreads, usePipelineLibrary);
+
+        for (uint32_t i = 0; i < options.pipelineVariants; i++) {
+            pipelineVariantIds.push_back(pipelineVariantCache->add(getPipelineVariant(i)));
+        }
+
+        std::cout << "Compiling " << options.pipelineVariants << " pipeline variant(s) on " << variantThreads << " thread(s)" << (usePipelineLibrary ? " from graphics pipeline libraries" : "") << std::endl;
+    }
+
+    // per variant id, what the draws bind this frame
+    std::vector<VkPipeline> variantPipelines(pipelineVariantIds.size());
+    uint64_t variantFallbackFrames = 0;
+
+    // pipelines replaced by a hot reload stay alive until the frames that used them have completed
+    std::vector<RetiredPipeline> retiredPipelines;
+
     vkDestroyShaderModule(device, fragShaderModule, nullptr);
     vkDestroyShaderModule(device, vertShaderModule, nullptr);
 
-    // swap chain framebuffers
+    // swap chain
+    startupProfiler.beginPhase("swap chain");
 
-    std::vector<VkFramebuffer> swapChainFramebuffers;
-    swapChainFramebuffers.resize(swapChainImageViews.size());
+    SwapChainSettings swapChainSettings{};
+    swapChainSettings.surface = surface;
+    swapChainSettings.surfaceFormat = surfaceFormat;
+    swapChainSettings.presentMode = presentMode;
+    swapChainSettings.graphicsQueueFamilyIndex = (uint32_t) queueFamilies.graphicsQueueFamilyIndex;
+    swapChainSettings.presentationQueueFamilyIndex = (uint32_t) queueFamilies.presentationQueueFamilyIndex;
+    swapChainSettings.renderPass = renderPass;
 
-    for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-        VkImageView attachments[] = {
-            swapChainImageViews[i]
-        };
+    int framebufferWidth = WINDOW_WIDTH;
+    int framebufferHeight = WINDOW_HEIGHT;
+
+    // time spent (re)creating the swap chain or offscreen targets, which is where the two rendering paths differ
+    const char* renderingPath = options.dynamicRendering ? "dynamic rendering" : "render pass";
+    double renderTargetSetupMilliseconds = 0.0;
+    uint32_t renderTargetSetupCount = 0;
+
+    SwapChain swapChain;
+
+    if (!options.headless) {
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = swapChainExtent.width;
-        framebufferInfo.height = swapChainExtent.height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) {
-            std::cerr << "Failed to create framebuffer" << std::endl;
+        auto setupStart = std::chrono::steady_clock::now();
+
+        if (!createSwapChain(device, physicalDevice, swapChainSettings, framebufferWidth, framebufferHeight, VK_NULL_HANDLE, swapChain)) {
+            std::cerr << "Failed to create swap chain" << std::endl;
             return 1;
         }
+
+        renderTargetSetupMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setupStart).count();
+        renderTargetSetupCount++;
     }
 
+    // swap chains replaced by a resize stay alive until the frames that used them have completed
+    std::vector<RetiredSwapChain> retiredSwapChains;
+
     // command pool
+    startupProfiler.beginPhase("resources");
 
     VkCommandPool commandPool;
 
@@ -829,121 +1681,499 @@ int main() {
         return 1;
     }
 
-    // command buffer
+    // per-frame resources; recording frame N+1 only waits for the frame that last used the same slot
 
-    VkCommandBuffer commandBuffer;
+    std::cout << "Creating resources for " << options.framesInFlight << " frame(s) in flight..." << std::endl;
+
+    std::vector<VkCommandBuffer> commandBuffers(options.framesInFlight);
 
     VkCommandBufferAllocateInfo commandBufferAllocInfo{};
     commandBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     commandBufferAllocInfo.commandPool = commandPool;
     commandBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    commandBufferAllocInfo.commandBufferCount = 1;
+    commandBufferAllocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
 
-    if (vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &commandBuffer) != VK_SUCCESS) {
+    if (vkAllocateCommandBuffers(device, &commandBufferAllocInfo, commandBuffers.data()) != VK_SUCCESS) {
         std::cerr << "Failed to allocate command buffers" << std::endl;
         return 1;
     }
 
+    // secondary command buffers recorded on worker threads, one pool per thread and frame slot
+    std::unique_ptr<ParallelRecorder> parallelRecorder;
+
+    if (options.recordThreads > 0) {
+        parallelRecorder = std::make_unique<ParallelRecorder>(device, queueFamilies.graphicsQueueFamilyIndex, options.recordThreads, options.framesInFlight);
+        std::cout << "Recording " << options.draws << " draw(s) per frame on " << options.recordThreads << " thread(s)" << std::endl;
+    }
+
     // create synchronization objects
     VkSemaphoreCreateInfo semaphoreCreateInfo{};
     semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceCreateInfo{};
-    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    std::vector<FrameResources> frames(options.framesInFlight);
 
-    VkSemaphore imageAvailableSemaphore;
-    VkSemaphore renderFinishedSemaphore;
-    VkFence inFlightFence;
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i].commandBuffer = commandBuffers[i];
 
-    if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &imageAvailableSemaphore) != VK_SUCCESS ||
-        vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &renderFinishedSemaphore) != VK_SUCCESS) {
-        std::cerr << "Failed to create semaphores" << std::endl;
-        return 1;
+        if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frames[i].imageAvailableSemaphore) != VK_SUCCESS) {
+            std::cerr << "Failed to create semaphores" << std::endl;
+            return 1;
+        }
     }
 
-    if (vkCreateFence(device, &fenceCreateInfo, nullptr, &inFlightFence) != VK_SUCCESS) {
-        std::cerr << "Failed to create fence" << std::endl;
-        return 1;
-    }
+    // timeline value of the frame that last rendered into each swap chain image
+    std::vector<uint64_t> imagesInFlight(swapChain.images.size(), 0);
 
     // create buffers
 
-    // vertex buffer
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
+    if (options.allocatorStressBuffers > 0) {
+        runAllocatorStress(device, *allocator, options.allocatorStressBuffers);
+    }
+
+    // offscreen render targets, one per frame slot, in place of the swap chain images
+    OffscreenTargets offscreenTargets;
 
-    {
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+    if (options.headless) {
+        VkExtent2D offscreenExtent = { static_cast<uint32_t>(WINDOW_WIDTH), static_cast<uint32_t>(WINDOW_HEIGHT) };
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+        auto setupStart = std::chrono::steady_clock::now();
 
-        void* data;
-        vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), (size_t)bufferSize);
-        vkUnmapMemory(device, stagingBufferMemory);
+        createOffscreenTargets(device, *allocator, renderPass, HEADLESS_FORMAT, offscreenExtent, options.framesInFlight, offscreenTargets);
 
-        createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
+        renderTargetSetupMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setupStart).count();
+        renderTargetSetupCount++;
 
-        copyBuffer(device, graphicsQueue, commandPool, stagingBuffer, vertexBuffer, bufferSize);
+        std::cout << "Rendering headless into " << options.framesInFlight << " offscreen " << offscreenExtent.width << "x" << offscreenExtent.height << " image(s)" << std::endl;
+    }
 
-        vkDestroyBuffer(device, stagingBuffer, nullptr);
-        vkFreeMemory(device, stagingBufferMemory, nullptr);
+    // frame captures, one readback buffer per frame slot
+    std::unique_ptr<FrameCapture> frameCapture;
+
+    if (options.captureEvery > 0) {
+        if (!FrameCapture::isFormatSupported(swapChainImageFormat)) {
+            std::cerr << "Frame capture does not support the swap chain format, captures are disabled" << std::endl;
+        } else if (!options.headless && !(swapChain.imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+            std::cerr << "Swap chain images cannot be copied from, captures are disabled" << std::endl;
+        } else {
+            frameCapture = std::make_unique<FrameCapture>(device, *allocator, options.framesInFlight, options.captureDirectory);
+            std::cout << "Capturing every " << options.captureEvery << " frame(s) to '" << options.captureDirectory << "'" << std::endl;
+        }
     }
 
+    UploadQueue::TransferQueue uploadTransferQueue{ transferQueue, (uint32_t) queueFamilies.transferQueueFamilyIndex, transferTimeline.get() };
+
+    auto uploadQueue = std::make_unique<UploadQueue>(device, *allocator, *timeline, graphicsQueue, queueFamilies.graphicsQueueFamilyIndex, useTransferQueue ? &uploadTransferQueue : nullptr);
+
+    std::cout << "[uploads] copying on the " << (uploadQueue->hasTransferQueue() ? "dedicated transfer" : "graphics") << " queue" << std::endl;
+
+    // GPU timestamps, one query range per frame slot
+    std::unique_ptr<GpuProfiler> gpuProfiler;
+
+    if (options.gpuProfile) {
+        if (!GpuProfiler::isSupported(physicalDevice, queueFamilies.graphicsQueueFamilyIndex)) {
+            std::cerr << "The graphics queue does not support timestamps, GPU profiling is disabled" << std::endl;
+        } else {
+            gpuProfiler = std::make_unique<GpuProfiler>(device, physicalDevice, queueFamilies.graphicsQueueFamilyIndex, options.framesInFlight);
+        }
+    }
+
+    // vertex buffer
+    VkBuffer vertexBuffer;
+    Allocation vertexBufferAllocation;
+
+    VkDeviceSize vertexBufferSize = sizeof(vertices[0]) * vertices.size();
+    createBuffer(device, *allocator, vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferAllocation);
+
     // index buffer
     VkBuffer indexBuffer;
-    VkDeviceMemory indexBufferMemory;
+    Allocation indexBufferAllocation;
+
+    VkDeviceSize indexBufferSize = sizeof(indices[0]) * indices.size();
+    createBuffer(device, *allocator, indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferAllocation);
+
+    // both copies go out with the first frame's upload batch instead of stalling here;
+    // uploads complete in order, so the index buffer handle covers the vertex buffer as well
+    uploadQueue->uploadBuffer(vertexBuffer, 0, vertices.data(), vertexBufferSize);
+    UploadHandle meshUpload = uploadQueue->uploadBuffer(indexBuffer, 0, indices.data(), indexBufferSize);
+    bool isMeshUploaded = false;
+
+    // bindless: a few checkerboard textures and material colors, each in its own array element
+    std::vector<Texture> bindlessTextures;
+    VkSampler bindlessSampler = VK_NULL_HANDLE;
+    VkBuffer materialBuffer = VK_NULL_HANDLE;
+    Allocation materialBufferAllocation;
+    std::vector<uint32_t> bindlessTextureIndices;
+    std::vector<uint32_t> bindlessMaterialIndices;
+
+    if (bindlessDescriptors) {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.maxLod = 0.0f;
+
+        if (vkCreateSampler(device, &samplerInfo, nullptr, &bindlessSampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create sampler!");
+        }
+
+        bindlessTextures.resize(BINDLESS_TEXTURE_COUNT);
+
+        for (uint32_t i = 0; i < BINDLESS_TEXTURE_COUNT; i++) {
+            Texture& texture = bindlessTextures[i];
+
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+            imageInfo.extent = { BINDLESS_TEXTURE_SIZE, BINDLESS_TEXTURE_SIZE, 1 };
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            createImage(device, *allocator, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.allocation);
+
+            VkImageViewCreateInfo imageViewInfo{};
+            imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            imageViewInfo.image = texture.image;
+            imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            imageViewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+            imageViewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+            if (vkCreateImageView(device, &imageViewInfo, nullptr, &texture.imageView) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create texture image view!");
+            }
+
+            // a different cell size and color per texture
+            uint32_t color = 0xff000000 | ((i & 1) ? 0x0000ff : 0x000080) | ((i & 2) ? 0x00ff00 : 0x008000) | ((i & 4) ? 0xff0000 : 0x800000);
+            auto texels = createCheckerboard(BINDLESS_TEXTURE_SIZE, 4u << (i % 3), color);
+
+            uploadQueue->uploadImage(texture.image, { BINDLESS_TEXTURE_SIZE, BINDLESS_TEXTURE_SIZE }, texels.data(), texels.size() * sizeof(texels[0]));
+
+            bindlessTextureIndices.push_back(bindlessDescriptors->addTexture(texture.imageView, bindlessSampler));
+        }
 
-    {
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+        // every material is a separate descriptor into one buffer
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+        VkDeviceSize storageAlignment = deviceProperties.limits.minStorageBufferOffsetAlignment;
+        VkDeviceSize materialStride = (sizeof(glm::vec4) + storageAlignment - 1) & ~(storageAlignment - 1);
 
-        void* data;
-        vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, indices.data(), (size_t)bufferSize);
-        vkUnmapMemory(device, stagingBufferMemory);
+        createBuffer(device, *allocator, materialStride * BINDLESS_MATERIAL_COUNT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, materialBuffer, materialBufferAllocation);
 
-        createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+        for (uint32_t i = 0; i < BINDLESS_MATERIAL_COUNT; i++) {
+            float shade = static_cast<float>(i) / BINDLESS_MATERIAL_COUNT;
+            glm::vec4 materialColor(1.0f - 0.5f * shade, 0.5f + 0.5f * shade, 1.0f, 1.0f);
 
-        copyBuffer(device, graphicsQueue, commandPool, stagingBuffer, indexBuffer, bufferSize);
+            uploadQueue->uploadBuffer(materialBuffer, materialStride * i, &materialColor, sizeof(materialColor));
 
-        vkDestroyBuffer(device, stagingBuffer, nullptr);
-        vkFreeMemory(device, stagingBufferMemory, nullptr);
+            bindlessMaterialIndices.push_back(bindlessDescriptors->addBuffer(materialBuffer, materialStride * i, sizeof(glm::vec4)));
+        }
+
+        std::cout << "[bindless] " << BINDLESS_TEXTURE_COUNT << " texture(s) and " << BINDLESS_MATERIAL_COUNT << " material(s) in one descriptor set" << std::endl;
+    }
+
+    // instancing: one host-visible instance buffer per frame slot, written in place by the CPU every frame
+    if (options.instances > 0) {
+        VkDeviceSize instanceBufferSize = sizeof(InstanceData) * static_cast<VkDeviceSize>(options.instances);
+
+        for (auto& frame : frames) {
+            createBuffer(device, *allocator, instanceBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.instanceBuffer, frame.instanceAllocation);
+        }
+
+        std::cout << "[instancing] " << options.instances << " instance(s) per draw, " << instanceBufferSize << " B of instance data per frame" << std::endl;
     }
 
+    // GPU culling: a square grid of objects, much larger than the view, that the camera pans across
+    std::unique_ptr<GpuCulling> gpuCulling;
+    float gpuCullingGridExtent = 0.0f;
+
+    if (options.gpuCullingObjects > 0) {
+        auto drawIndexedIndirectCount = hasDrawIndirectCount ? reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR")) : nullptr;
+
+        gpuCulling = std::make_unique<GpuCulling>(device, *allocator, pipelineCache->get(), readShader(options, "cull_comp.spv").getCode(), options.gpuCullingObjects, static_cast<uint32_t>(indices.size()), options.framesInFlight, drawIndexedIndirectCount);
+
+        uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(options.gpuCullingObjects))));
+        gpuCullingGridExtent = gridSize * GPU_CULLING_OBJECT_SPACING;
+
+        // the bounding sphere goes through the quad's corners, which are 0.5 * scale away on both axes
+        std::vector<GpuCulling::Object> objects(options.gpuCullingObjects);
+
+        for (uint32_t i = 0; i < options.gpuCullingObjects; i++) {
+            objects[i] = GpuCulling::Object(
+                (i % gridSize) * GPU_CULLING_OBJECT_SPACING - gpuCullingGridExtent * 0.5f,
+                (i / gridSize) * GPU_CULLING_OBJECT_SPACING - gpuCullingGridExtent * 0.5f,
+                GPU_CULLING_OBJECT_SCALE,
+                GPU_CULLING_OBJECT_SCALE * std::sqrt(0.5f));
+        }
+
+        uploadQueue->uploadBuffer(gpuCulling->getObjectBuffer(), 0, objects.data(), gpuCulling->getObjectBufferSize());
+
+        std::cout << "[gpu culling] " << options.gpuCullingObjects << " object(s), drawn with "
+                  << (gpuCulling->isCompacting() ? "vkCmdDrawIndexedIndirectCount" : "multi-draw vkCmdDrawIndexedIndirect") << std::endl;
+    }
+
+    // particles: stepped by a compute pass every frame, on the async compute queue when there is one
+    std::unique_ptr<ComputeScheduler> computeScheduler;
+    std::unique_ptr<ParticleSimulation> particleSimulation;
+
+    if (options.particles > 0) {
+        std::vector<uint32_t> particleQueueFamilies = { (uint32_t) queueFamilies.graphicsQueueFamilyIndex };
+
+        if (useComputeQueue) {
+            particleQueueFamilies.push_back((uint32_t) queueFamilies.computeQueueFamilyIndex);
+        }
+
+        computeScheduler = std::make_unique<ComputeScheduler>(device, computeQueue, (uint32_t) queueFamilies.computeQueueFamilyIndex, computeTimeline.get(), options.framesInFlight);
+        particleSimulation = std::make_unique<ParticleSimulation>(device, *allocator, pipelineCache->get(), readShader(options, "particles_comp.spv").getCode(), options.particles, particleQueueFamilies);
+
+        std::cout << "[particles] " << options.particles << " particle(s), simulated on the " << (computeScheduler->isAsync() ? "async compute" : "graphics") << " queue" << std::endl;
+    }
+
+    // upload stress: a device-local buffer that is overwritten in 1 MiB uploads every frame
+    VkBuffer uploadStressBuffer = VK_NULL_HANDLE;
+    Allocation uploadStressAllocation;
+    std::vector<char> uploadStressData;
+    UploadHandle uploadStressUpload;
+
+    if (options.uploadStressMegabytes > 0) {
+        createBuffer(device, *allocator, UPLOAD_STRESS_CHUNK_SIZE * options.uploadStressMegabytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, uploadStressBuffer, uploadStressAllocation);
+        uploadStressData.assign(static_cast<size_t>(UPLOAD_STRESS_CHUNK_SIZE), 0x5a);
+    }
+
+    printAllocatorStats("startup", allocator->getStats());
+
     // proceed to main setup
 
+    startupProfiler.beginPhase("first frame");
+
     std::cout << "Running main loop..." << std::endl;
 
-    glfwSetKeyCallback(window, key_callback);
+    bool framebufferResized = false;
+
+    if (!options.headless) {
+        glfwSetKeyCallback(window, key_callback);
+
+        glfwSetWindowUserPointer(window, &framebufferResized);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    }
 
     bool isRunning = true;
+    bool isSwapChainOutOfDate = false;
+
+    uint32_t currentFrame = 0;
+    uint64_t frameCount = 0;
+    uint32_t swapChainRecreations = 0;
+
+    // the resize storm keeps rendering for a while at the original size, so the last swap chains get retired too
+    const uint64_t resizeStormSettleFrames = 60 + options.framesInFlight;
+
+    std::vector<double> resizeStormFrameTimes;
+    resizeStormFrameTimes.reserve(options.resizeStormFrames + resizeStormSettleFrames);
+
+    auto lastFrameStart = std::chrono::steady_clock::now();
+
+    FrameBenchmark benchmark("vulkan_glfw", "Vulkan", FrameBenchmarkOptions{ options.benchmarkFrames, options.benchmarkOutput });
+    benchmark.setMetadata("framesInFlight", options.framesInFlight);
+    benchmark.setMetadata("mode", options.headless ? "headless" : "windowed");
+    benchmark.setMetadata("recordThreads", options.recordThreads);
+    benchmark.setMetadata("draws", options.draws);
+    benchmark.setMetadata("gpuCullingObjects", options.gpuCullingObjects);
+    benchmark.setMetadata("instances", options.instances);
+    benchmark.setMetadata("renderingPath", renderingPath);
+    benchmark.setMetadata("uploadQueue", uploadQueue->hasTransferQueue() ? "transfer" : "graphics");
+    benchmark.setMetadata("uploadStressMiB", options.uploadStressMegabytes);
+    benchmark.setMetadata("shaders", options.useUnoptimizedShaders ? "unoptimized" : "optimized");
+    benchmark.setMetadata("shaderSource", usesEmbeddedShaders(options) ? "embedded" : "file");
+    benchmark.setMetadata("particles", options.particles);
+    benchmark.setMetadata("pipelineVariants", options.pipelineVariants);
+    benchmark.setMetadata("pipelineLibrary", usePipelineLibrary ? "yes" : "no");
+    benchmark.setMetadata("computeQueue", computeScheduler && computeScheduler->isAsync() ? "async" : "graphics");
+
+    // the wait for the particle step that the next frame draws, when it ran on the compute queue
+    std::optional<TimelineScheduler::Wait> particleStepWait;
+
+    auto loopStart = std::chrono::steady_clock::now();
 
     while (isRunning) {
-        glfwPollEvents();
+        if (!options.headless) {
+            glfwPollEvents();
 
-        if (glfwWindowShouldClose(window)) {
-            isRunning = false;
+            if (glfwWindowShouldClose(window)) {
+                isRunning = false;
+            }
+        }
+
+        // resize storm: a new window size every few frames, then back to the original one
+        if (options.resizeStormFrames > 0) {
+            if (frameCount < options.resizeStormFrames && frameCount % 3 == 0) {
+                uint64_t step = frameCount / 3;
+                glfwSetWindowSize(window, static_cast<int>(320 + (step * 97) % 960), static_cast<int>(240 + (step * 61) % 540));
+            } else if (frameCount == options.resizeStormFrames) {
+                glfwSetWindowSize(window, WINDOW_WIDTH, WINDOW_HEIGHT);
+            }
+        }
+
+        if (isSwapChainOutOfDate || framebufferResized) {
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+            // minimized: there is nothing to render into until the window is restored
+            if (framebufferWidth == 0 || framebufferHeight == 0) {
+                glfwWaitEvents();
+                continue;
+            }
+
+            // the old swap chain is passed as oldSwapchain and kept alive for the frames still using it,
+            // so the frames in flight don't have to be drained first
+            SwapChain newSwapChain;
+
+            auto setupStart = std::chrono::steady_clock::now();
+
+            if (!createSwapChain(device, physicalDevice, swapChainSettings, framebufferWidth, framebufferHeight, swapChain.handle, newSwapChain)) {
+                glfwWaitEvents();
+                continue;
+            }
+
+            renderTargetSetupMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setupStart).count();
+            renderTargetSetupCount++;
+
+            // every frame that used it has been submitted already
+            retiredSwapChains.push_back(RetiredSwapChain{ std::move(swapChain), timeline->getSubmittedValue() });
+            swapChain = std::move(newSwapChain);
+
+            imagesInFlight.assign(swapChain.images.size(), 0);
+
+            isSwapChainOutOfDate = false;
+            framebufferResized = false;
+            swapChainRecreations++;
+        }
+
+        FrameResources& frame = frames[currentFrame];
+
+        // wait for the frame that last used this slot
+
+        timeline->wait(frame.timelineValue);
+
+        for (auto it = retiredSwapChains.begin(); it != retiredSwapChains.end();) {
+            if (timeline->isComplete(it->lastUseValue)) {
+                destroySwapChain(device, it->swapChain);
+                it = retiredSwapChains.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (auto it = retiredPipelines.begin(); it != retiredPipelines.end();) {
+            if (timeline->isComplete(it->lastUseValue)) {
+                vkDestroyPipeline(device, it->pipeline, nullptr);
+                it = retiredPipelines.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // nothing recorded from here on uses the old pipeline, and every frame that did has been submitted
+        if (shaderHotReload) {
+            VkPipeline reloadedPipeline = shaderHotReload->takePipeline();
+
+            if (reloadedPipeline != VK_NULL_HANDLE) {
+                retiredPipelines.push_back(RetiredPipeline{ graphicsPipeline, timeline->getSubmittedValue() });
+                graphicsPipeline = reloadedPipeline;
+            }
         }
 
-        double time = glfwGetTime();
+        // variants that are still being compiled are drawn with the graphics pipeline
+        if (pipelineVariantCache) {
+            bool isFallbackUsed = false;
 
-        // wait for available frame
+            for (size_t i = 0; i < pipelineVariantIds.size(); i++) {
+                VkPipeline variantPipeline = pipelineVariantCache->getPipeline(pipelineVariantIds[i]);
+                isFallbackUsed |= variantPipeline == VK_NULL_HANDLE;
+                variantPipelines[i] = variantPipeline != VK_NULL_HANDLE ? variantPipeline : graphicsPipeline;
+            }
 
-        vkWaitForFences(device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
-        vkResetFences(device, 1, &inFlightFence);
+            if (isFallbackUsed) {
+                variantFallbackFrames++;
+            }
+        }
 
-        uint32_t imageIndex;
-        vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+        // the copy recorded the last time this slot was used has landed; encoding happens on the capture thread
+        if (frameCapture) {
+            frameCapture->collect(currentFrame);
+        }
+
+        // same for the timestamps of the slot's last frame
+        if (gpuProfiler) {
+            gpuProfiler->beginFrame(currentFrame, frameCount);
+        }
+
+        // headless: each frame slot renders into its own offscreen image
+        uint32_t imageIndex = currentFrame;
+
+        if (!options.headless) {
+            VkResult acquireResult = vkAcquireNextImageKHR(device, swapChain.handle, UINT64_MAX, frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+
+            // out of date: the semaphore was not signaled and the slot's frame has completed, so the slot can be reused as is;
+            // suboptimal: the image was acquired and is rendered and presented normally, present reports it again
+            if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+                isSwapChainOutOfDate = true;
+                continue;
+            }
+
+            if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
+                std::cerr << "Failed to acquire swap chain image" << std::endl;
+                break;
+            }
+
+            // with more frames in flight than swap chain images, an older frame may still be rendering into this image
+            timeline->wait(imagesInFlight[imageIndex]);
+        }
+
+        benchmark.beginFrame();
+
+        // submit uploads queued since the last frame; they are ordered before the draw on the same queue.
+        // this happens before the frame is recorded, so the profiler sees the command buffers in submission order
+        for (uint32_t i = 0; i < options.uploadStressMegabytes; i++) {
+            uploadStressUpload = uploadQueue->uploadBuffer(uploadStressBuffer, UPLOAD_STRESS_CHUNK_SIZE * i, uploadStressData.data(), UPLOAD_STRESS_CHUNK_SIZE);
+        }
+
+        uploadQueue->flush(gpuProfiler.get());
+
+        // the slot's previous frame has completed, so its uniforms and instance data can be overwritten
+        uniformRing->beginFrame(currentFrame);
+
+        if (bindlessDescriptors) {
+            bindlessDescriptors->beginFrame(frameCount);
+        }
+
+        if (options.instances > 0) {
+            writeInstances(static_cast<InstanceData*>(frame.instanceAllocation.mappedData), options.instances, static_cast<float>(frameCount) / 60.0f);
+        }
+
+        // dynamic rendering has no framebuffers and renders into the image view directly
+        VkFramebuffer targetFramebuffer = VK_NULL_HANDLE;
+
+        if (!options.dynamicRendering) {
+            targetFramebuffer = options.headless ? offscreenTargets.framebuffers[imageIndex] : swapChain.framebuffers[imageIndex];
+        }
+
+        VkImage targetImage = options.headless ? offscreenTargets.images[imageIndex] : swapChain.images[imageIndex];
+        VkImageView targetImageView = options.headless ? offscreenTargets.imageViews[imageIndex] : swapChain.imageViews[imageIndex];
+        VkExtent2D targetExtent = options.headless ? offscreenTargets.extent : swapChain.extent;
+        VkImageLayout targetLayout = options.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         // fill command buffer
 
+        VkCommandBuffer commandBuffer = frame.commandBuffer;
+
         vkResetCommandBuffer(commandBuffer, /*VkCommandBufferResetFlagBits*/ 0);
 
         VkCommandBufferBeginInfo beginInfo{};
@@ -955,46 +2185,314 @@ int main() {
             std::cerr << "Failed to begin recording command buffer" << std::endl;
         }
 
+        if (gpuProfiler) {
+            gpuProfiler->beginScope(commandBuffer, "frame");
+        }
+
+        // GPU culling: the camera circles over the grid, a view of 2 x 2 around its position
+        glm::vec4 camera(0.0f, 0.0f, 1.0f, 0.0f);
+
+        if (gpuCulling) {
+            float t = static_cast<float>(frameCount) * 0.002f;
+            camera.x = std::sin(t) * gpuCullingGridExtent * 0.4f;
+            camera.y = std::cos(t * 0.7f) * gpuCullingGridExtent * 0.4f;
+
+            float halfWidth = 1.0f / camera.z;
+
+            GpuCulling::FrustumPlanes frustumPlanes = {
+                glm::vec4(1.0f, 0.0f, 0.0f, halfWidth - camera.x),
+                glm::vec4(-1.0f, 0.0f, 0.0f, halfWidth + camera.x),
+                glm::vec4(0.0f, 1.0f, 0.0f, halfWidth - camera.y),
+                glm::vec4(0.0f, -1.0f, 0.0f, halfWidth + camera.y),
+                // the scene is flat, so near and far never cull anything
+                glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+                glm::vec4(0.0f, 0.0f, -1.0f, 1.0f)
+            };
+
+            if (gpuProfiler) {
+                gpuProfiler->beginScope(commandBuffer, "culling");
+            }
+
+            gpuCulling->recordCulling(commandBuffer, currentFrame, frustumPlanes);
+
+            if (gpuProfiler) {
+                gpuProfiler->endScope(commandBuffer);
+            }
+        }
+
+        // particles: this frame's step overwrites what the previous frame drew, so it waits for everything submitted
+        // to the graphics queue so far; the frame itself draws the previous step, which runs alongside it
+        std::optional<TimelineScheduler::Wait> drawnParticleStepWait = particleStepWait;
+
+        if (particleSimulation) {
+            computeScheduler->addPass([&](VkCommandBuffer computeCommandBuffer) {
+                particleSimulation->recordStep(computeCommandBuffer, PARTICLE_TIME_STEP);
+            });
+
+            // the profiler's queries belong to the graphics queue
+            bool isProfiled = gpuProfiler && !computeScheduler->isAsync();
+
+            if (isProfiled) {
+                gpuProfiler->beginScope(commandBuffer, "particles");
+            }
+
+            particleStepWait = computeScheduler->flush(currentFrame, commandBuffer, TimelineScheduler::Wait{ timeline.get(), timeline->getSubmittedValue(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT });
+
+            if (isProfiled) {
+                gpuProfiler->endScope(commandBuffer);
+            }
+        }
+
+        if (gpuProfiler) {
+            gpuProfiler->beginScope(commandBuffer, "render pass");
+        }
+
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassInfo.renderPass = renderPass;
 
-        renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
+        renderPassInfo.framebuffer = targetFramebuffer;
 
         renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = swapChainExtent;
+        renderPassInfo.renderArea.extent = targetExtent;
 
         VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
         renderPassInfo.clearValueCount = 1;
         renderPassInfo.pClearValues = &clearColor;
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        VkImageSubresourceRange colorSubresourceRange{};
+        colorSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        colorSubresourceRange.baseMipLevel = 0;
+        colorSubresourceRange.levelCount = 1;
+        colorSubresourceRange.baseArrayLayer = 0;
+        colorSubresourceRange.layerCount = 1;
+
+        // dynamic rendering: the layout transitions the render pass does for its attachment are explicit barriers
+        auto beginRendering = [&](bool hasSecondaryCommandBuffers) {
+            if (!options.dynamicRendering) {
+                vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, hasSecondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+                return;
+            }
+
+            // the image is cleared, so its previous contents are discarded; the wait for the acquire semaphore
+            // happens at the color attachment output stage
+            VkImageMemoryBarrier2 toAttachmentBarrier{};
+            toAttachmentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            toAttachmentBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+            toAttachmentBarrier.srcAccessMask = VK_ACCESS_2_NONE;
+            toAttachmentBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+            toAttachmentBarrier.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+            toAttachmentBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            toAttachmentBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            toAttachmentBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            toAttachmentBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            toAttachmentBarrier.image = targetImage;
+            toAttachmentBarrier.subresourceRange = colorSubresourceRange;
+
+            VkDependencyInfo dependencyInfo{};
+            dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            dependencyInfo.imageMemoryBarrierCount = 1;
+            dependencyInfo.pImageMemoryBarriers = &toAttachmentBarrier;
+
+            cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+            VkRenderingAttachmentInfo colorAttachmentInfo{};
+            colorAttachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            colorAttachmentInfo.imageView = targetImageView;
+            colorAttachmentInfo.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorAttachmentInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachmentInfo.clearValue = clearColor;
+
+            VkRenderingInfo renderingInfo{};
+            renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+            renderingInfo.flags = hasSecondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+            renderingInfo.renderArea = renderPassInfo.renderArea;
+            renderingInfo.layerCount = 1;
+            renderingInfo.colorAttachmentCount = 1;
+            renderingInfo.pColorAttachments = &colorAttachmentInfo;
+
+            cmdBeginRendering(commandBuffer, &renderingInfo);
+        };
+
+        auto endRendering = [&]() {
+            if (!options.dynamicRendering) {
+                vkCmdEndRenderPass(commandBuffer);
+                return;
+            }
+
+            cmdEndRendering(commandBuffer);
+
+            // the render pass's final layout, and its dependency for frame captures
+            VkImageMemoryBarrier2 fromAttachmentBarrier{};
+            fromAttachmentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            fromAttachmentBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+            fromAttachmentBarrier.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+            fromAttachmentBarrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            fromAttachmentBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+            fromAttachmentBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            fromAttachmentBarrier.newLayout = targetLayout;
+            fromAttachmentBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            fromAttachmentBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            fromAttachmentBarrier.image = targetImage;
+            fromAttachmentBarrier.subresourceRange = colorSubresourceRange;
+
+            VkDependencyInfo dependencyInfo{};
+            dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            dependencyInfo.imageMemoryBarrierCount = 1;
+            dependencyInfo.pImageMemoryBarriers = &fromAttachmentBarrier;
+
+            cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+        };
+
+        auto setViewportAndScissor = [&](VkCommandBuffer drawCommandBuffer) {
+            VkViewport viewport{};
+            viewport.x = 0.0f;
+            viewport.y = 0.0f;
+            viewport.width = static_cast<float>(targetExtent.width);
+            viewport.height = static_cast<float>(targetExtent.height);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            vkCmdSetViewport(drawCommandBuffer, 0, 1, &viewport);
+
+            VkRect2D scissor{};
+            scissor.offset = {0, 0};
+            scissor.extent = targetExtent;
+            vkCmdSetScissor(drawCommandBuffer, 0, 1, &scissor);
+        };
+
+        // the draws are laid out on a square grid; a single draw covers the same area as the plain quad
+        uint32_t drawUniformsOffset = uniformRing->allocate(std::max(options.draws, 1u));
+        uint32_t drawGridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(options.draws, 1u)))));
+        float drawCellSize = 2.0f / drawGridSize;
+
+        // secondary command buffers inherit none of the state, so every one of them binds everything again
+        auto recordDraws = [&](VkCommandBuffer drawCommandBuffer, uint32_t firstDraw, uint32_t drawCount) {
+            bool isInstanced = options.instances > 0;
+
+            VkPipeline boundPipeline = isInstanced ? instancedPipeline : (bindlessDescriptors ? bindlessPipeline : graphicsPipeline);
+            vkCmdBindPipeline(drawCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundPipeline);
+            setViewportAndScissor(drawCommandBuffer);
+
+            // bound once; the draws only differ in the indices they push
+            if (bindlessDescriptors) {
+                VkDescriptorSet bindlessSet = bindlessDescriptors->getDescriptorSet();
+                vkCmdBindDescriptorSets(drawCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &bindlessSet, 0, nullptr);
+            }
+
+            VkBuffer vertexBuffers[] = { vertexBuffer, frame.instanceBuffer };
+            VkDeviceSize offsets[] = { 0, 0 };
+            vkCmdBindVertexBuffers(drawCommandBuffer, 0, isInstanced ? 2 : 1, vertexBuffers, offsets);
+            vkCmdBindIndexBuffer(drawCommandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+
+            for (uint32_t draw = firstDraw; draw < firstDraw + drawCount; draw++) {
+                // each draw owns one block of the ring, so threads never write to the same memory
+                uint32_t dynamicOffset = drawUniformsOffset + uniformRing->getBlockStride() * draw;
+
+                // the variants take turns; all of them share the layout, so the bound sets and push constants stay
+                if (!variantPipelines.empty() && variantPipelines[draw % variantPipelines.size()] != boundPipeline) {
+                    boundPipeline = variantPipelines[draw % variantPipelines.size()];
+                    vkCmdBindPipeline(drawCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundPipeline);
+                }
+
+                auto uniforms = static_cast<DrawUniforms*>(uniformRing->getMappedData(dynamicOffset));
+                uniforms->transform = glm::mat4(drawCellSize * 0.5f);
+                uniforms->transform[2].z = 1.0f;
+                uniforms->transform[3] = glm::vec4(-1.0f + ((draw % drawGridSize) + 0.5f) * drawCellSize, -1.0f + ((draw / drawGridSize) + 0.5f) * drawCellSize, 0.0f, 1.0f);
+
+                DrawPushConstants pushConstants{};
+                float shade = 0.5f + 0.5f * static_cast<float>(draw + 1) / static_cast<float>(options.draws);
+                pushConstants.tint = glm::vec4(shade, shade, shade, 1.0f);
+
+                if (bindlessDescriptors) {
+                    pushConstants.textureIndex = bindlessTextureIndices[draw % bindlessTextureIndices.size()];
+                    pushConstants.materialIndex = bindlessMaterialIndices[(draw / bindlessTextureIndices.size()) % bindlessMaterialIndices.size()];
+                }
+
+                VkDescriptorSet drawSet = uniformRing->getDescriptorSet();
+                vkCmdBindDescriptorSets(drawCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &drawSet, 1, &dynamicOffset);
+                if (drawPushConstantRange.stageFlags != 0) {
+                    vkCmdPushConstants(drawCommandBuffer, pipelineLayout, drawPushConstantRange.stageFlags, drawPushConstantRange.offset, drawPushConstantRange.size, reinterpret_cast<const char*>(&pushConstants) + drawPushConstantRange.offset);
+                }
+
+                // vertex_count, instance_count, first_vertex, first_instance
+                vkCmdDrawIndexed(drawCommandBuffer, static_cast<uint32_t>(indices.size()), isInstanced ? options.instances : 1, 0, 0, 0);
+            }
+        };
+
+        if (parallelRecorder) {
+            beginRendering(true);
+
+            // with dynamic rendering the secondaries are told the attachment formats instead of the render pass
+            VkCommandBufferInheritanceRenderingInfo inheritanceRenderingInfo{};
+            inheritanceRenderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+            inheritanceRenderingInfo.colorAttachmentCount = 1;
+            inheritanceRenderingInfo.pColorAttachmentFormats = &swapChainImageFormat;
+            inheritanceRenderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+            VkCommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.pNext = options.dynamicRendering ? &inheritanceRenderingInfo : nullptr;
+            inheritanceInfo.renderPass = renderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = targetFramebuffer;
+
+            const auto& secondaryCommandBuffers = parallelRecorder->record(currentFrame, inheritanceInfo, options.draws, recordDraws);
+            vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+        } else if (gpuCulling) {
+            beginRendering(false);
+
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, scenePipeline);
+            setViewportAndScissor(commandBuffer);
+
+            VkBuffer sceneVertexBuffers[] = { vertexBuffer, gpuCulling->getObjectBuffer() };
+            VkDeviceSize sceneOffsets[] = { 0, 0 };
+            vkCmdBindVertexBuffers(commandBuffer, 0, 2, sceneVertexBuffers, sceneOffsets);
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+            vkCmdPushConstants(commandBuffer, scenePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(camera), &camera);
+
+            gpuCulling->recordDraw(commandBuffer, currentFrame);
+        } else if (particleSimulation) {
+            beginRendering(false);
+
+            // the first frame has no finished step to draw yet
+            if (particleSimulation->getStepCount() > 1) {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipeline);
+                setViewportAndScissor(commandBuffer);
+
+                VkBuffer particleVertexBuffers[] = { vertexBuffer, particleSimulation->getRenderBuffer() };
+                VkDeviceSize particleOffsets[] = { 0, 0 };
+                vkCmdBindVertexBuffers(commandBuffer, 0, 2, particleVertexBuffers, particleOffsets);
+                vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+
+                vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), particleSimulation->getParticleCount(), 0, 0, 0);
+            }
+        } else {
+            beginRendering(false);
+            recordDraws(commandBuffer, 0, options.draws);
+        }
 
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        endRendering();
 
-        VkViewport viewport{};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = static_cast<float>(swapChainExtent.width);
-        viewport.height = static_cast<float>(swapChainExtent.height);
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        if (gpuProfiler) {
+            gpuProfiler->endScope(commandBuffer);
+        }
 
-        VkRect2D scissor{};
-        scissor.offset = {0, 0};
-        scissor.extent = swapChainExtent;
-        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        if (frameCapture && frameCount % options.captureEvery == 0) {
+            if (gpuProfiler) {
+                gpuProfiler->beginScope(commandBuffer, "capture");
+            }
 
-        VkBuffer vertexBuffers[] = { vertexBuffer };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+            frameCapture->record(commandBuffer, currentFrame, frameCount, targetImage, targetLayout, swapChainImageFormat, targetExtent);
 
-        // vertex_count, instance_count, first_vertex, first_instance
-        vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+            if (gpuProfiler) {
+                gpuProfiler->endScope(commandBuffer);
+            }
+        }
 
-        vkCmdEndRenderPass(commandBuffer);
+        if (gpuProfiler) {
+            gpuProfiler->endScope(commandBuffer);
+        }
 
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             std::cerr << "Failed to record command buffer" << std::endl;
@@ -1005,92 +2503,319 @@ int main() {
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-        VkSemaphore waitSemaphores[] = {imageAvailableSemaphore};
+        // headless frames have no image to wait for and nothing to present, the timeline is all they need
+        VkSemaphore waitSemaphores[] = {frame.imageAvailableSemaphore};
         VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.waitSemaphoreCount = options.headless ? 0 : 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
 
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        VkSemaphore signalSemaphores[] = {renderFinishedSemaphore};
-        submitInfo.signalSemaphoreCount = 1;
+        VkSemaphore signalSemaphores[] = {options.headless ? VK_NULL_HANDLE : swapChain.renderFinishedSemaphores[imageIndex]};
+        submitInfo.signalSemaphoreCount = options.headless ? 0 : 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFence) != VK_SUCCESS) {
+        std::vector<TimelineScheduler::Wait> frameTimelineWaits;
+
+        if (drawnParticleStepWait) {
+            frameTimelineWaits.push_back(*drawnParticleStepWait);
+        }
+
+        if (timeline->submit(graphicsQueue, submitInfo, frame.timelineValue, frameTimelineWaits) != VK_SUCCESS) {
             std::cerr << "Failed to submit draw command buffer" << std::endl;
         }
 
-        VkPresentInfoKHR presentInfo{};
-        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        if (!options.headless) {
+            imagesInFlight[imageIndex] = frame.timelineValue;
+        }
+
+        benchmark.endFrame();
+
+        if (!options.headless) {
+            VkPresentInfoKHR presentInfo{};
+            presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+            presentInfo.waitSemaphoreCount = 1;
+            presentInfo.pWaitSemaphores = signalSemaphores;
+
+            VkSwapchainKHR swapChains[] = {swapChain.handle};
+            presentInfo.swapchainCount = 1;
+            presentInfo.pSwapchains = swapChains;
+
+            presentInfo.pImageIndices = &imageIndex;
+
+            VkResult presentResult = vkQueuePresentKHR(presentQueue, &presentInfo);
+
+            if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+                isSwapChainOutOfDate = true;
+            } else if (presentResult != VK_SUCCESS) {
+                std::cerr << "Failed to present swap chain image" << std::endl;
+            }
+        }
+
+        benchmark.markPresent();
+
+        // startup ends with the first frame presented, or rendered when headless
+        if (!startupProfiler.hasPresented()) {
+            if (options.headless) {
+                timeline->wait(frame.timelineValue);
+            }
+
+            startupProfiler.markFirstPresent();
+            startupProfiler.print();
+        }
+
+        currentFrame = (currentFrame + 1) % options.framesInFlight;
+        frameCount++;
+
+        if (!isMeshUploaded && meshUpload.isReady()) {
+            std::cout << "Mesh upload completed after " << frameCount << " frame(s)" << std::endl;
+            isMeshUploaded = true;
+        }
+
+        if (gpuProfiler && frameCount % GPU_PROFILER_REPORT_INTERVAL == 0) {
+            gpuProfiler->printAverages();
+        }
 
-        presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = signalSemaphores;
+        if (benchmark.isFinished()) {
+            isRunning = false;
+        }
 
-        VkSwapchainKHR swapChains[] = {swapChain};
-        presentInfo.swapchainCount = 1;
-        presentInfo.pSwapchains = swapChains;
+        if (options.resizeStormFrames > 0) {
+            auto frameEnd = std::chrono::steady_clock::now();
+            resizeStormFrameTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - lastFrameStart).count());
+            lastFrameStart = frameEnd;
 
-        presentInfo.pImageIndices = &imageIndex;
+            if (frameCount >= options.resizeStormFrames + resizeStormSettleFrames) {
+                isRunning = false;
+            }
+        }
+    }
 
-        vkQueuePresentKHR(presentQueue, &presentInfo);
+    double renderTargetSetupAverage = renderTargetSetupCount > 0 ? renderTargetSetupMilliseconds / renderTargetSetupCount : 0.0;
+
+    std::cout << "[render targets] " << renderingPath << ": " << renderTargetSetupCount << " setup(s), "
+              << renderTargetSetupAverage << " ms on average" << std::endl;
+
+    if (options.benchmarkFrames > 0) {
+        benchmark.setMetadata("renderTargetSetupMs", renderTargetSetupAverage);
+        benchmark.setMetadata("startupMs", startupProfiler.getTotalMilliseconds());
+        benchmark.setMetadata("startupPipelineCache", pipelineCache->isWarm() ? "warm" : "cold");
+        benchmark.setMetadata("fastStart", options.fastStart ? "yes" : "no");
+        benchmark.writeResults();
+    }
+
+    if (options.instances > 0 && frameCount > 0) {
+        double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+        double instanceCount = static_cast<double>(options.instances) * options.draws * frameCount;
+
+        std::cout << "[instancing] " << instanceCount << " instances in " << frameCount << " frame(s) over " << loopSeconds << " s: "
+                  << instanceCount / loopSeconds << " instances/s" << std::endl;
+    }
+
+    if (particleSimulation && frameCount > 0) {
+        double loopMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loopStart).count();
+
+        std::cout << "[particles] " << options.particles << " particle(s) on the " << (computeScheduler->isAsync() ? "async compute" : "graphics") << " queue, "
+                  << frameCount << " frame(s): " << loopMilliseconds / frameCount << " ms per frame" << std::endl;
+    }
+
+    if (options.uploadStressMegabytes > 0 && frameCount > 0) {
+        // until the last copy has landed
+        uploadStressUpload.wait();
+
+        double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+        double megabytes = static_cast<double>(uploadQueue->getSubmittedBytes()) / (1024.0 * 1024.0);
+
+        std::cout << "[uploads] " << megabytes << " MiB on the " << (uploadQueue->hasTransferQueue() ? "dedicated transfer" : "graphics") << " queue in "
+                  << loopSeconds << " s: " << megabytes / loopSeconds << " MiB/s" << std::endl;
+    }
+
+    bool isResizeStormFailed = false;
+
+    if (options.resizeStormFrames > 0 && !resizeStormFrameTimes.empty()) {
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+        // after settling, the swap chain must match the window and every retired swap chain must be gone
+        bool isExtentCurrent = swapChain.extent.width == static_cast<uint32_t>(framebufferWidth) && swapChain.extent.height == static_cast<uint32_t>(framebufferHeight);
+        isResizeStormFailed = !isExtentCurrent || !retiredSwapChains.empty();
+
+        std::cout << "[resize storm] frames: " << frameCount
+                  << ", swap chain recreations: " << swapChainRecreations
+                  << ", retired swap chains alive: " << retiredSwapChains.size()
+                  << ", extent: " << swapChain.extent.width << "x" << swapChain.extent.height
+                  << ", framebuffer: " << framebufferWidth << "x" << framebufferHeight
+                  << ", worst frame: " << *std::max_element(resizeStormFrameTimes.begin(), resizeStormFrameTimes.end()) << " ms"
+                  << ", result: " << (isResizeStormFailed ? "FAILED" : "passed") << std::endl;
     }
 
     std::cout << "Waiting for device to become idle..." << std::endl;
     vkDeviceWaitIdle(device);
 
+    if (shaderHotReload) {
+        std::cout << "[hot reload] " << shaderHotReload->getReloadCount() << " pipeline rebuild(s), " << shaderHotReload->getFailureCount() << " failed" << std::endl;
+
+        std::cout << "Stopping shader hot reload..." << std::endl;
+        shaderHotReload.reset();
+    }
+
+    if (pipelineVariantCache) {
+        double allReadyTime = pipelineVariantCache->getAllReadyMilliseconds();
+
+        std::cout << "[variants] " << pipelineVariantCache->getReadyCount() << " of " << pipelineVariantCache->getVariantCount() << " variant(s) ready, "
+                  << pipelineVariantCache->getFailureCount() << " failed, " << (allReadyTime >= 0.0 ? "all done after " + std::to_string(allReadyTime) + " ms" : std::string("still compiling"))
+                  << ", " << variantFallbackFrames << " frame(s) drew with the fallback pipeline" << (pipelineVariantCache->usesGraphicsPipelineLibrary() ? ", linked from graphics pipeline libraries" : "") << std::endl;
+
+        // waits for the compilations in progress, before the pipeline cache is saved
+        std::cout << "Destroying pipeline variants..." << std::endl;
+        pipelineVariantCache.reset();
+    }
+
+    if (frameCapture) {
+        std::cout << "Finishing frame captures..." << std::endl;
+        frameCapture.reset();
+    }
+
+    if (gpuProfiler) {
+        gpuProfiler->collectAll();
+        gpuProfiler->printAverages();
+        gpuProfiler->writeChromeTrace(options.gpuTracePath);
+
+        std::cout << "Destroying GPU profiler..." << std::endl;
+        gpuProfiler.reset();
+    }
+
     std::cout << "Destroying semaphores..." << std::endl;
-    vkDestroySemaphore(device, imageAvailableSemaphore, nullptr);
-    vkDestroySemaphore(device, renderFinishedSemaphore, nullptr);
 
-    std::cout << "Destroying fence..." << std::endl;
-    vkDestroyFence(device, inFlightFence, nullptr);
+    for (auto& frame : frames) {
+        vkDestroySemaphore(device, frame.imageAvailableSemaphore, nullptr);
+    }
+
+    if (uploadStressBuffer != VK_NULL_HANDLE) {
+        destroyBuffer(device, *allocator, uploadStressBuffer, uploadStressAllocation);
+    }
+
+    if (options.instances > 0) {
+        std::cout << "Destroying instance buffers..." << std::endl;
+
+        for (auto& frame : frames) {
+            destroyBuffer(device, *allocator, frame.instanceBuffer, frame.instanceAllocation);
+        }
+    }
+
+    if (bindlessDescriptors) {
+        std::cout << "Destroying bindless resources..." << std::endl;
+
+        for (auto& texture : bindlessTextures) {
+            vkDestroyImageView(device, texture.imageView, nullptr);
+            destroyImage(device, *allocator, texture.image, texture.allocation);
+        }
+
+        destroyBuffer(device, *allocator, materialBuffer, materialBufferAllocation);
+        vkDestroySampler(device, bindlessSampler, nullptr);
+    }
+
+    if (gpuCulling) {
+        std::cout << "Destroying GPU culling..." << std::endl;
+        gpuCulling.reset();
+    }
+
+    if (particleSimulation) {
+        std::cout << "Destroying particle simulation..." << std::endl;
+        particleSimulation.reset();
+        computeScheduler.reset();
+    }
 
     std::cout << "Destroying vertex buffer..." << std::endl;
-    vkDestroyBuffer(device, vertexBuffer, nullptr);
-    vkFreeMemory(device, vertexBufferMemory, nullptr);
+    destroyBuffer(device, *allocator, vertexBuffer, vertexBufferAllocation);
 
     std::cout << "Destroying index buffer..." << std::endl;
-    vkDestroyBuffer(device, indexBuffer, nullptr);
-    vkFreeMemory(device, indexBufferMemory, nullptr);
+    destroyBuffer(device, *allocator, indexBuffer, indexBufferAllocation);
 
-    std::cout << "Destroying swap chain image views..." << std::endl;
+    std::cout << "Destroying swap chain..." << std::endl;
 
-    for (auto imageView : swapChainImageViews) {
-        vkDestroyImageView(device, imageView, nullptr);
+    for (auto& retiredSwapChain : retiredSwapChains) {
+        destroySwapChain(device, retiredSwapChain.swapChain);
     }
 
-    std::cout << "Destroying swap chain framebuffers..." << std::endl;
+    destroySwapChain(device, swapChain);
 
-    for (auto framebuffer : swapChainFramebuffers) {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
+    if (options.headless) {
+        std::cout << "Destroying offscreen targets..." << std::endl;
+        destroyOffscreenTargets(device, *allocator, offscreenTargets);
     }
 
     vkDestroyPipeline(device, graphicsPipeline, nullptr);
 
+    for (auto& retiredPipeline : retiredPipelines) {
+        vkDestroyPipeline(device, retiredPipeline.pipeline, nullptr);
+    }
+
+    if (bindlessPipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, bindlessPipeline, nullptr);
+    }
+
+    if (instancedPipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, instancedPipeline, nullptr);
+    }
+
+    if (scenePipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, scenePipeline, nullptr);
+    }
+
+    std::cout << "Saving pipeline cache..." << std::endl;
+    pipelineCache->save();
+    pipelineCache.reset();
+
+    std::cout << "Destroying pipeline layouts..." << std::endl;
+    pipelineLayoutCache.reset();
+
     std::cout << "Destroying render pass..." << std::endl;
-    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     vkDestroyRenderPass(device, renderPass, nullptr);
 
+    if (parallelRecorder) {
+        std::cout << "Stopping recording threads..." << std::endl;
+        parallelRecorder.reset();
+    }
+
     std::cout << "Destroying command pool..." << std::endl;
     vkDestroyCommandPool(device, commandPool, nullptr);
 
-    std::cout << "Destroying swap chain..." << std::endl;
-    vkDestroySwapchainKHR(device, swapChain, nullptr);
-
     std::cout << "Destroying surface..." << std::endl;
     // must be called after associated swapchain is destroyed
     vkDestroySurfaceKHR(instance, surface, nullptr);
 
+    std::cout << "Destroying uniform ring..." << std::endl;
+    uniformRing.reset();
+
+    if (bindlessDescriptors) {
+        std::cout << "Destroying bindless descriptors..." << std::endl;
+        bindlessDescriptors.reset();
+    }
+
+    std::cout << "Destroying upload queue..." << std::endl;
+    uploadQueue.reset();
+
+    std::cout << "Destroying timeline semaphores..." << std::endl;
+    timeline.reset();
+    transferTimeline.reset();
+    computeTimeline.reset();
+
+    std::cout << "Destroying memory allocator..." << std::endl;
+    allocator.reset();
+
     std::cout << "Destroying logical device..." << std::endl;
     vkDestroyDevice(device, nullptr);
 
     std::cout << "Destroying Vulkan instance..." << std::endl;
     vkDestroyInstance(instance, nullptr);
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (!options.headless) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
-    return 0;
+    return isResizeStormFailed ? 1 : 0;
 }
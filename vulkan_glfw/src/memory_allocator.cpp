@@ -0,0 +1,327 @@
+#include "memory_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+static uint32_t ceilLog2(VkDeviceSize value) {
+    return static_cast<uint32_t>(std::bit_width(std::max<VkDeviceSize>(value, 1) - 1));
+}
+
+static uint32_t floorLog2(VkDeviceSize value) {
+    return static_cast<uint32_t>(std::bit_width(value) - 1);
+}
+
+static VkDeviceSize orderSize(uint32_t order) {
+    return VkDeviceSize{ 1 } << order;
+}
+
+DeviceMemoryAllocator::DeviceMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize preferredBlockSize) :
+    device(device),
+    preferredBlockSize(preferredBlockSize) {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+    bufferImageGranularity = deviceProperties.limits.bufferImageGranularity;
+    maxMemoryAllocationCount = deviceProperties.limits.maxMemoryAllocationCount;
+}
+
+DeviceMemoryAllocator::~DeviceMemoryAllocator() {
+    for (auto& [key, pool] : pools) {
+        for (auto& block : pool.blocks) {
+            vkFreeMemory(device, block->memory, nullptr);
+        }
+    }
+}
+
+uint32_t DeviceMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+DeviceMemoryAllocator::Pool& DeviceMemoryAllocator::getPool(uint32_t memoryTypeIndex, ResourceKind kind) {
+    // without a granularity restriction linear and optimal resources can share blocks
+    if (bufferImageGranularity <= 1) {
+        kind = ResourceKind::Linear;
+    }
+
+    auto [it, inserted] = pools.try_emplace({ memoryTypeIndex, kind });
+    Pool& pool = it->second;
+
+    if (inserted) {
+        // keep blocks small enough that a handful of them fits into the heap
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+        VkDeviceSize blockSize = std::min(preferredBlockSize, std::max<VkDeviceSize>(heapSize / 8, orderSize(MIN_ORDER + 1)));
+
+        pool.memoryTypeIndex = memoryTypeIndex;
+        pool.maxOrder = floorLog2(blockSize);
+    }
+
+    return pool;
+}
+
+VkDeviceMemory DeviceMemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData) {
+    if (deviceMemoryAllocations >= maxMemoryAllocationCount) {
+        throw std::runtime_error("exceeded maxMemoryAllocationCount!");
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkDeviceMemory memory;
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory!");
+    }
+
+    *mappedData = nullptr;
+
+    // host-visible memory stays mapped for its whole lifetime
+    if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mappedData) != VK_SUCCESS) {
+            vkFreeMemory(device, memory, nullptr);
+            throw std::runtime_error("failed to map device memory!");
+        }
+    }
+
+    deviceMemoryAllocations++;
+
+    return memory;
+}
+
+MemoryBlock* DeviceMemoryAllocator::createBlock(Pool& pool) {
+    auto block = std::make_unique<MemoryBlock>();
+
+    block->memory = allocateDeviceMemory(orderSize(pool.maxOrder), pool.memoryTypeIndex, &block->mappedData);
+    block->maxOrder = pool.maxOrder;
+    block->freeLists.resize(pool.maxOrder + 1);
+    block->freeLists[pool.maxOrder].insert(0);
+
+    pool.blocks.push_back(std::move(block));
+
+    return pool.blocks.back().get();
+}
+
+void DeviceMemoryAllocator::destroyBlock(MemoryBlock* block) {
+    vkFreeMemory(device, block->memory, nullptr);
+    deviceMemoryAllocations--;
+
+    for (auto& [key, pool] : pools) {
+        std::erase_if(pool.blocks, [block](const auto& candidate) { return candidate.get() == block; });
+    }
+}
+
+static bool allocateFromBlock(MemoryBlock& block, uint32_t order, VkDeviceSize& offset) {
+    uint32_t freeOrder = order;
+
+    while (freeOrder <= block.maxOrder && block.freeLists[freeOrder].empty()) {
+        freeOrder++;
+    }
+
+    if (freeOrder > block.maxOrder) {
+        return false;
+    }
+
+    offset = *block.freeLists[freeOrder].begin();
+    block.freeLists[freeOrder].erase(block.freeLists[freeOrder].begin());
+
+    // split the range, returning the upper halves to the free lists
+    while (freeOrder > order) {
+        freeOrder--;
+        block.freeLists[freeOrder].insert(offset + orderSize(freeOrder));
+    }
+
+    block.allocatedBytes += orderSize(order);
+
+    return true;
+}
+
+Allocation DeviceMemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind) {
+    uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+    uint32_t order = std::max({ MIN_ORDER, ceilLog2(requirements.size), ceilLog2(requirements.alignment) });
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Pool& pool = getPool(memoryTypeIndex, kind);
+
+    Allocation allocation{};
+    allocation.size = requirements.size;
+
+    // anything bigger than half a block would waste most of it, so it gets its own VkDeviceMemory
+    if (order >= pool.maxOrder) {
+        allocation.memory = allocateDeviceMemory(requirements.size, memoryTypeIndex, &allocation.mappedData);
+        dedicatedBytes += requirements.size;
+    } else {
+        MemoryBlock* block = nullptr;
+        VkDeviceSize offset = 0;
+
+        for (auto& candidate : pool.blocks) {
+            if (allocateFromBlock(*candidate, order, offset)) {
+                block = candidate.get();
+                break;
+            }
+        }
+
+        if (!block) {
+            block = createBlock(pool);
+            allocateFromBlock(*block, order, offset);
+        }
+
+        allocation.memory = block->memory;
+        allocation.offset = offset;
+        allocation.mappedData = block->mappedData ? static_cast<char*>(block->mappedData) + offset : nullptr;
+        allocation.block = block;
+        allocation.order = order;
+    }
+
+    allocationCount++;
+    bytesUsed += requirements.size;
+
+    return allocation;
+}
+
+void DeviceMemoryAllocator::free(Allocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    allocationCount--;
+    bytesUsed -= allocation.size;
+
+    if (!allocation.block) {
+        vkFreeMemory(device, allocation.memory, nullptr);
+        deviceMemoryAllocations--;
+        dedicatedBytes -= allocation.size;
+        allocation = {};
+        return;
+    }
+
+    MemoryBlock* block = allocation.block;
+    VkDeviceSize offset = allocation.offset;
+    uint32_t order = allocation.order;
+
+    block->allocatedBytes -= orderSize(order);
+
+    // merge with the buddy for as long as it is free as well
+    while (order < block->maxOrder) {
+        VkDeviceSize buddy = offset ^ orderSize(order);
+        auto it = block->freeLists[order].find(buddy);
+
+        if (it == block->freeLists[order].end()) {
+            break;
+        }
+
+        block->freeLists[order].erase(it);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+
+    block->freeLists[order].insert(offset);
+
+    allocation = {};
+
+    // release empty blocks, but keep the last one of a pool so alloc/free churn does not hit the driver
+    if (block->allocatedBytes == 0) {
+        for (auto& [key, pool] : pools) {
+            bool ownsBlock = std::any_of(pool.blocks.begin(), pool.blocks.end(), [block](const auto& candidate) { return candidate.get() == block; });
+
+            if (ownsBlock && pool.blocks.size() > 1) {
+                destroyBlock(block);
+                break;
+            }
+        }
+    }
+}
+
+AllocatorStats DeviceMemoryAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    AllocatorStats stats{};
+    stats.deviceMemoryAllocations = deviceMemoryAllocations;
+    stats.allocationCount = allocationCount;
+    stats.bytesUsed = bytesUsed;
+    stats.bytesReserved = dedicatedBytes;
+    stats.bytesAllocated = dedicatedBytes;
+
+    for (const auto& [key, pool] : pools) {
+        for (const auto& block : pool.blocks) {
+            stats.bytesReserved += orderSize(block->maxOrder);
+            stats.bytesAllocated += block->allocatedBytes;
+
+            for (uint32_t order = block->maxOrder + 1; order-- > 0;) {
+                if (!block->freeLists[order].empty()) {
+                    stats.largestFreeRange = std::max(stats.largestFreeRange, orderSize(order));
+                    break;
+                }
+            }
+        }
+    }
+
+    VkDeviceSize freeBytes = stats.bytesReserved - stats.bytesAllocated;
+
+    if (freeBytes > 0) {
+        stats.fragmentation = 1.0 - static_cast<double>(stats.largestFreeRange) / static_cast<double>(freeBytes);
+    }
+
+    return stats;
+}
+
+void createBuffer(VkDevice device, DeviceMemoryAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferAllocation, const std::vector<uint32_t>& queueFamilyIndices) {
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (queueFamilyIndices.size() > 1) {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilyIndices.size());
+        bufferInfo.pQueueFamilyIndices = queueFamilyIndices.data();
+    }
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+    bufferAllocation = allocator.allocate(memRequirements, properties, ResourceKind::Linear);
+
+    vkBindBufferMemory(device, buffer, bufferAllocation.memory, bufferAllocation.offset);
+}
+
+void destroyBuffer(VkDevice device, DeviceMemoryAllocator& allocator, VkBuffer buffer, Allocation& bufferAllocation) {
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator.free(bufferAllocation);
+}
+
+void createImage(VkDevice device, DeviceMemoryAllocator& allocator, const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageAllocation) {
+    if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+    ResourceKind kind = imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear;
+    imageAllocation = allocator.allocate(memRequirements, properties, kind);
+
+    vkBindImageMemory(device, image, imageAllocation.memory, imageAllocation.offset);
+}
+
+void destroyImage(VkDevice device, DeviceMemoryAllocator& allocator, VkImage image, Allocation& imageAllocation) {
+    vkDestroyImage(device, image, nullptr);
+    allocator.free(imageAllocation);
+}
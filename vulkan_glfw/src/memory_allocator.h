@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+// Buffers and linear images may share a page with each other, but not with optimal-tiling images
+// (see bufferImageGranularity), so each kind gets its own set of blocks.
+enum class ResourceKind {
+    Linear,
+    Optimal
+};
+
+struct MemoryBlock;
+
+struct Allocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mappedData = nullptr;
+
+    MemoryBlock* block = nullptr; // nullptr for dedicated allocations
+    uint32_t order = 0;
+};
+
+struct AllocatorStats {
+    uint32_t deviceMemoryAllocations = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize bytesReserved = 0; // total size of VkDeviceMemory objects
+    VkDeviceSize bytesUsed = 0; // sum of the requested sizes
+    VkDeviceSize bytesAllocated = 0; // sum of the sizes after rounding up to a power of two
+    VkDeviceSize largestFreeRange = 0;
+    double fragmentation = 0.0; // 1 - largestFreeRange / freeBytes
+};
+
+// Block-based buddy allocator: one vkAllocateMemory per block, split into power-of-two ranges.
+// Buddy ranges are aligned to their own size, which covers VkMemoryRequirements::alignment.
+class DeviceMemoryAllocator {
+public:
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+    static constexpr uint32_t MIN_ORDER = 8; // 256 bytes
+
+    DeviceMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE);
+    ~DeviceMemoryAllocator();
+
+    DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+    DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+
+    Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind);
+    void free(Allocation& allocation);
+
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+    AllocatorStats getStats() const;
+
+private:
+    struct Pool {
+        uint32_t memoryTypeIndex;
+        uint32_t maxOrder;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+    };
+
+    Pool& getPool(uint32_t memoryTypeIndex, ResourceKind kind);
+    MemoryBlock* createBlock(Pool& pool);
+    void destroyBlock(MemoryBlock* block);
+    VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData);
+
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize bufferImageGranularity;
+    uint32_t maxMemoryAllocationCount;
+    VkDeviceSize preferredBlockSize;
+
+    mutable std::mutex mutex;
+    std::map<std::pair<uint32_t, ResourceKind>, Pool> pools;
+
+    uint32_t deviceMemoryAllocations = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize dedicatedBytes = 0;
+    VkDeviceSize bytesUsed = 0;
+};
+
+// with more than one queue family, the buffer is shared concurrently between them instead of owned by one at a time
+void createBuffer(VkDevice device, DeviceMemoryAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& bufferAllocation, const std::vector<uint32_t>& queueFamilyIndices = {});
+void destroyBuffer(VkDevice device, DeviceMemoryAllocator& allocator, VkBuffer buffer, Allocation& bufferAllocation);
+
+void createImage(VkDevice device, DeviceMemoryAllocator& allocator, const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageAllocation);
+void destroyImage(VkDevice device, DeviceMemoryAllocator& allocator, VkImage image, Allocation& imageAllocation);
+
+struct MemoryBlock {
+    VkDeviceMemory memory;
+    void* mappedData;
+    uint32_t maxOrder;
+    VkDeviceSize allocatedBytes = 0;
+
+    // free ranges (offsets) per order, ordered so the lowest offset is reused first
+    std::vector<std::set<VkDeviceSize>> freeLists;
+};
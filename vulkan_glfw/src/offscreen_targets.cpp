@@ -0,0 +1,84 @@
+#include "offscreen_targets.h"
+
+#include <stdexcept>
+
+void createOffscreenTargets(VkDevice device, DeviceMemoryAllocator& allocator, VkRenderPass renderPass, VkFormat format, VkExtent2D extent, uint32_t count, OffscreenTargets& targets) {
+    targets.format = format;
+    targets.extent = extent;
+    targets.images.resize(count);
+    targets.imageAllocations.resize(count);
+    targets.imageViews.resize(count);
+    targets.framebuffers.resize(renderPass != VK_NULL_HANDLE ? count : 0);
+
+    for (uint32_t i = 0; i < count; i++) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = format;
+        imageInfo.extent = { extent.width, extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        // transfer source so frames can be copied out for captures
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        createImage(device, allocator, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, targets.images[i], targets.imageAllocations[i]);
+
+        VkImageViewCreateInfo imageViewCreateInfo{};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.image = targets.images[i];
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = format;
+
+        imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+        imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+        imageViewCreateInfo.subresourceRange.levelCount = 1;
+        imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        imageViewCreateInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device, &imageViewCreateInfo, nullptr, &targets.imageViews[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen image view!");
+        }
+
+        if (renderPass == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &targets.imageViews[i];
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &targets.framebuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen framebuffer!");
+        }
+    }
+}
+
+void destroyOffscreenTargets(VkDevice device, DeviceMemoryAllocator& allocator, OffscreenTargets& targets) {
+    for (auto framebuffer : targets.framebuffers) {
+        vkDestroyFramebuffer(device, framebuffer, nullptr);
+    }
+
+    for (auto imageView : targets.imageViews) {
+        vkDestroyImageView(device, imageView, nullptr);
+    }
+
+    for (size_t i = 0; i < targets.images.size(); i++) {
+        destroyImage(device, allocator, targets.images[i], targets.imageAllocations[i]);
+    }
+
+    targets = OffscreenTargets{};
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "memory_allocator.h"
+
+// Color images that stand in for the swap chain when rendering headless. There is one image per frame slot,
+// so waiting for the slot's previous frame is all the synchronization an image needs. Without a render pass (dynamic rendering)
+// only the images and views are created.
+struct OffscreenTargets {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+    std::vector<VkImage> images;
+    std::vector<Allocation> imageAllocations;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkFramebuffer> framebuffers;
+};
+
+void createOffscreenTargets(VkDevice device, DeviceMemoryAllocator& allocator, VkRenderPass renderPass, VkFormat format, VkExtent2D extent, uint32_t count, OffscreenTargets& targets);
+void destroyOffscreenTargets(VkDevice device, DeviceMemoryAllocator& allocator, OffscreenTargets& targets);
@@ -0,0 +1,135 @@
+#include "parallel_recorder.h"
+
+#include <stdexcept>
+
+ParallelRecorder::ParallelRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t threadCount, uint32_t slotCount) :
+    device(device),
+    threads(threadCount),
+    recordedCommandBuffers(threadCount) {
+    for (auto& thread : threads) {
+        thread.commandPools.resize(slotCount);
+        thread.commandBuffers.resize(slotCount);
+
+        for (uint32_t slot = 0; slot < slotCount; slot++) {
+            VkCommandPoolCreateInfo poolCreateInfo{};
+            poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+            if (vkCreateCommandPool(device, &poolCreateInfo, nullptr, &thread.commandPools[slot]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create recording thread command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = thread.commandPools[slot];
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device, &allocInfo, &thread.commandBuffers[slot]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+        }
+    }
+
+    for (uint32_t i = 1; i < threadCount; i++) {
+        workers.emplace_back(&ParallelRecorder::workerLoop, this, i);
+    }
+}
+
+ParallelRecorder::~ParallelRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+
+    workAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // destroying a pool frees its command buffers
+    for (auto& thread : threads) {
+        for (VkCommandPool commandPool : thread.commandPools) {
+            vkDestroyCommandPool(device, commandPool, nullptr);
+        }
+    }
+}
+
+const std::vector<VkCommandBuffer>& ParallelRecorder::record(uint32_t slot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunction& recordRange) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        jobSlot = slot;
+        jobInheritance = &inheritance;
+        jobItemCount = itemCount;
+        jobRecordRange = &recordRange;
+
+        pendingWorkers = static_cast<uint32_t>(workers.size());
+        generation++;
+    }
+
+    workAvailable.notify_all();
+
+    recordShare(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return pendingWorkers == 0; });
+
+    return recordedCommandBuffers;
+}
+
+void ParallelRecorder::workerLoop(uint32_t threadIndex) {
+    uint64_t lastGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this, lastGeneration] { return isStopping || generation != lastGeneration; });
+
+            if (isStopping) {
+                return;
+            }
+
+            lastGeneration = generation;
+        }
+
+        recordShare(threadIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (--pendingWorkers == 0) {
+                workDone.notify_one();
+            }
+        }
+    }
+}
+
+void ParallelRecorder::recordShare(uint32_t threadIndex) {
+    uint32_t threadCount = static_cast<uint32_t>(threads.size());
+    uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(jobItemCount) * threadIndex / threadCount);
+    uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(jobItemCount) * (threadIndex + 1) / threadCount);
+
+    VkCommandBuffer commandBuffer = threads[threadIndex].commandBuffers[jobSlot];
+
+    // the slot's frame has completed, so everything allocated from the pool can go at once
+    vkResetCommandPool(device, threads[threadIndex].commandPools[jobSlot], 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = jobInheritance;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    // an empty share still gets an (empty) command buffer, so the result always has one per thread
+    if (end > first) {
+        (*jobRecordRange)(commandBuffer, first, end - first);
+    }
+
+    vkEndCommandBuffer(commandBuffer);
+
+    recordedCommandBuffers[threadIndex] = commandBuffer;
+}
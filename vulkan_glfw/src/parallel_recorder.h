@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Records the contents of a render pass on several threads. Every thread has its own command pool per frame slot with
+// one secondary command buffer in it; the pool is reset as a whole when the slot comes around again, which is cheaper
+// than resetting individual command buffers. The calling thread records the first share of the work itself.
+class ParallelRecorder {
+public:
+    // records items [first, first + count) into commandBuffer, which has been begun already
+    using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)>;
+
+    ParallelRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t threadCount, uint32_t slotCount);
+    ~ParallelRecorder();
+
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+    // Splits itemCount items evenly over the threads and returns once all of them are recorded. The returned
+    // secondary command buffers are to be executed in order inside the render pass described by inheritance,
+    // or inside dynamic rendering when it chains a VkCommandBufferInheritanceRenderingInfo.
+    // The command buffers recorded for the slot last time must have completed.
+    const std::vector<VkCommandBuffer>& record(uint32_t slot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunction& recordRange);
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(threads.size()); }
+
+private:
+    // per frame slot
+    struct ThreadResources {
+        std::vector<VkCommandPool> commandPools;
+        std::vector<VkCommandBuffer> commandBuffers;
+    };
+
+    void workerLoop(uint32_t threadIndex);
+    void recordShare(uint32_t threadIndex);
+
+    VkDevice device;
+
+    // index 0 is the calling thread
+    std::vector<ThreadResources> threads;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    uint64_t generation = 0;
+    uint32_t pendingWorkers = 0;
+    bool isStopping = false;
+
+    // the current job, set before generation is bumped
+    uint32_t jobSlot = 0;
+    const VkCommandBufferInheritanceInfo* jobInheritance = nullptr;
+    uint32_t jobItemCount = 0;
+    const RecordFunction* jobRecordRange = nullptr;
+
+    std::vector<VkCommandBuffer> recordedCommandBuffers;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "memory_allocator.h"
+
+// Particles orbiting an attractor at the center of the view, integrated by a compute shader (shaders/particles.comp)
+// in a number of substeps per step. The particles are written in the per-instance layout of the instanced pipeline, so
+// they are drawn straight from the buffer the simulation writes.
+//
+// There are two particle buffers: each step reads the one the previous step wrote and writes the other. A frame draws
+// the particles of the step before the one it records, so the step and the draw never touch the same buffer and can
+// run at the same time on different queues.
+class ParticleSimulation {
+public:
+    // xy position, zw scale, and a color
+    struct Particle {
+        glm::vec4 transform;
+        glm::vec4 color;
+    };
+
+    static constexpr uint32_t WORKGROUP_SIZE = 64;
+    static constexpr uint32_t SUBSTEPS = 32;
+
+    // the particle buffers are shared concurrently by the given queue families when there is more than one
+    ParticleSimulation(VkDevice device, DeviceMemoryAllocator& allocator, VkPipelineCache pipelineCache, std::span<const uint32_t> shaderCode, uint32_t particleCount, const std::vector<uint32_t>& queueFamilyIndices);
+    ~ParticleSimulation();
+
+    ParticleSimulation(const ParticleSimulation&) = delete;
+    ParticleSimulation& operator=(const ParticleSimulation&) = delete;
+
+    uint32_t getParticleCount() const { return particleCount; }
+    uint64_t getStepCount() const { return stepCount; }
+
+    // usable as a per-instance vertex buffer: the particles written by the step before the last recorded one, which
+    // that step reads. Valid once two steps have been recorded.
+    VkBuffer getRenderBuffer() const { return particleBuffers[stepCount % 2]; }
+
+    // outside of a render pass; whatever read the buffer this step writes (the one drawn two steps ago) must be done.
+    // The first step places the particles on their orbits.
+    void recordStep(VkCommandBuffer commandBuffer, float deltaTime);
+
+private:
+    VkDevice device;
+    DeviceMemoryAllocator& allocator;
+    uint32_t particleCount;
+    uint64_t stepCount = 0;
+
+    std::array<VkBuffer, 2> particleBuffers;
+    std::array<Allocation, 2> particleAllocations;
+    VkBuffer velocityBuffer;
+    Allocation velocityAllocation;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    // descriptorSets[i] writes particleBuffers[i] and reads the other one
+    std::array<VkDescriptorSet, 2> descriptorSets;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+};
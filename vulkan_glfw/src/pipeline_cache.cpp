@@ -0,0 +1,156 @@
+#include "pipeline_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+static std::vector<char> readCacheFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+    if (!file.is_open()) {
+        return {};
+    }
+
+    size_t fileSize = (size_t)file.tellg();
+    std::vector<char> buffer(fileSize);
+
+    file.seekg(0);
+    file.read(buffer.data(), fileSize);
+
+    return buffer;
+}
+
+// checks the VkPipelineCacheHeaderVersionOne at the start of the data against the device
+static bool validateCacheHeader(const std::vector<char>& data, const VkPhysicalDeviceProperties& deviceProperties, std::string& reason) {
+    VkPipelineCacheHeaderVersionOne header;
+
+    if (data.size() < sizeof(header)) {
+        reason = "file is too small";
+        return false;
+    }
+
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (header.headerSize < sizeof(header) || header.headerSize > data.size()) {
+        reason = "invalid header size";
+        return false;
+    }
+
+    if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+        reason = "unsupported header version";
+        return false;
+    }
+
+    if (header.vendorID != deviceProperties.vendorID || header.deviceID != deviceProperties.deviceID) {
+        reason = "created for a different device";
+        return false;
+    }
+
+    if (memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        reason = "created by a different driver version";
+        return false;
+    }
+
+    return true;
+}
+
+PersistentPipelineCache::PersistentPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, std::filesystem::path path, bool loadFromDisk) :
+    device(device),
+    path(std::move(path)) {
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+    std::vector<char> data;
+
+    if (!loadFromDisk) {
+        coldReason = "disabled";
+    } else {
+        data = readCacheFile(this->path);
+
+        if (data.empty()) {
+            coldReason = "no cache file";
+        } else if (!validateCacheHeader(data, deviceProperties, coldReason)) {
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheCreateInfo{};
+    cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheCreateInfo.initialDataSize = data.size();
+    cacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &cache) == VK_SUCCESS) {
+        warm = !data.empty();
+        loadedSize = data.size();
+        return;
+    }
+
+    // the driver rejected data that passed the header check; start over with an empty cache
+    coldReason = "rejected by the driver";
+
+    cacheCreateInfo.initialDataSize = 0;
+    cacheCreateInfo.pInitialData = nullptr;
+
+    if (vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &cache) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+PersistentPipelineCache::~PersistentPipelineCache() {
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+void PersistentPipelineCache::save() const {
+    size_t dataSize = 0;
+
+    if (vkGetPipelineCacheData(device, cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+        return;
+    }
+
+    std::vector<char> data(dataSize);
+
+    if (vkGetPipelineCacheData(device, cache, &dataSize, data.data()) != VK_SUCCESS) {
+        std::cerr << "[PersistentPipelineCache] Failed to read pipeline cache data" << std::endl;
+        return;
+    }
+
+    // write next to the target and rename, so a crash never leaves a truncated cache behind
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open()) {
+            std::cerr << "[PersistentPipelineCache] Failed to open '" << temporaryPath.string() << "' for writing" << std::endl;
+            return;
+        }
+
+        file.write(data.data(), static_cast<std::streamsize>(dataSize));
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    if (error) {
+        std::cerr << "[PersistentPipelineCache] Failed to write '" << path.string() << "': " << error.message() << std::endl;
+    }
+}
+
+std::filesystem::path getExecutableDirectory(const char* argv0) {
+    std::error_code error;
+
+#ifdef __linux__
+    auto executablePath = std::filesystem::read_symlink("/proc/self/exe", error);
+
+    if (!error) {
+        return executablePath.parent_path();
+    }
+#endif
+
+    auto absolutePath = std::filesystem::absolute(argv0, error);
+
+    return error ? std::filesystem::current_path() : absolutePath.parent_path();
+}
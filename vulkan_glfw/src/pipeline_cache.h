@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <filesystem>
+#include <string>
+
+// VkPipelineCache backed by a file. The file is only used when its header matches the current
+// device (vendorID, deviceID and pipelineCacheUUID); otherwise the cache starts empty.
+class PersistentPipelineCache {
+public:
+    PersistentPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, std::filesystem::path path, bool loadFromDisk = true);
+    ~PersistentPipelineCache();
+
+    PersistentPipelineCache(const PersistentPipelineCache&) = delete;
+    PersistentPipelineCache& operator=(const PersistentPipelineCache&) = delete;
+
+    VkPipelineCache get() const { return cache; }
+
+    // true when the cache was seeded from a valid file
+    bool isWarm() const { return warm; }
+
+    // why the file was not used, for a cold cache
+    const std::string& getColdReason() const { return coldReason; }
+
+    size_t getLoadedSize() const { return loadedSize; }
+
+    void save() const;
+
+private:
+    VkDevice device;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    std::filesystem::path path;
+    bool warm = false;
+    std::string coldReason;
+    size_t loadedSize = 0;
+};
+
+std::filesystem::path getExecutableDirectory(const char* argv0);
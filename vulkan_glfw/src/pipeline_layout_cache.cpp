@@ -0,0 +1,135 @@
+#include "pipeline_layout_cache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// FNV-1a over the values the layouts are created from, field by field so padding never takes part
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+static void hashValue(uint64_t& hash, uint64_t value) {
+    for (uint32_t i = 0; i < sizeof(value); i++) {
+        hash = (hash ^ ((value >> (i * 8)) & 0xff)) * FNV_PRIME;
+    }
+}
+
+static bool isSameBinding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+    return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+}
+
+PipelineLayoutCache::PipelineLayoutCache(VkDevice device) :
+    device(device) {
+}
+
+PipelineLayoutCache::~PipelineLayoutCache() {
+    for (auto& [hash, cached] : pipelineLayouts) {
+        vkDestroyPipelineLayout(device, cached.layout, nullptr);
+    }
+
+    for (auto& [hash, cached] : setLayouts) {
+        vkDestroyDescriptorSetLayout(device, cached.layout, nullptr);
+    }
+}
+
+VkDescriptorSetLayout PipelineLayoutCache::getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    for (const auto& binding : bindings) {
+        hashValue(hash, binding.binding);
+        hashValue(hash, binding.descriptorType);
+        hashValue(hash, binding.descriptorCount);
+        hashValue(hash, binding.stageFlags);
+    }
+
+    auto [first, last] = setLayouts.equal_range(hash);
+
+    for (auto it = first; it != last; ++it) {
+        if (std::equal(bindings.begin(), bindings.end(), it->second.bindings.begin(), it->second.bindings.end(), isSameBinding)) {
+            hitCount++;
+            return it->second.layout;
+        }
+    }
+
+    for (const auto& binding : bindings) {
+        // an unbounded array needs binding flags and a pool the generated layouts know nothing about
+        if (binding.descriptorCount == 0) {
+            throw std::runtime_error("failed to create descriptor set layout: binding " + std::to_string(binding.binding) + " is a runtime-sized array!");
+        }
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    setLayouts.emplace(hash, CachedSetLayout{ bindings, layout });
+
+    return layout;
+}
+
+VkPipelineLayout PipelineLayoutCache::getPipelineLayout(const ShaderReflection& reflection, const std::vector<ExternalSetLayout>& externalSetLayouts, const std::string& name) {
+    uint32_t setCount = reflection.getSetCount();
+
+    for (const auto& external : externalSetLayouts) {
+        setCount = std::max(setCount, external.set + 1);
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayoutHandles(setCount);
+
+    for (uint32_t set = 0; set < setCount; set++) {
+        auto external = std::find_if(externalSetLayouts.begin(), externalSetLayouts.end(), [&](const ExternalSetLayout& e) { return e.set == set; });
+
+        if (external != externalSetLayouts.end()) {
+            validateDescriptorSetLayout(reflection, set, external->bindings, name);
+            setLayoutHandles[set] = external->layout;
+        } else {
+            setLayoutHandles[set] = getDescriptorSetLayout(reflection.getSetLayoutBindings(set));
+        }
+    }
+
+    const auto& range = reflection.pushConstantRange;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    for (auto setLayout : setLayoutHandles) {
+        hashValue(hash, reinterpret_cast<uint64_t>(setLayout));
+    }
+
+    hashValue(hash, range.stageFlags);
+    hashValue(hash, range.offset);
+    hashValue(hash, range.size);
+
+    auto [first, last] = pipelineLayouts.equal_range(hash);
+
+    for (auto it = first; it != last; ++it) {
+        const auto& cachedRange = it->second.pushConstantRange;
+
+        if (it->second.setLayouts == setLayoutHandles && cachedRange.stageFlags == range.stageFlags && cachedRange.offset == range.offset && cachedRange.size == range.size) {
+            hitCount++;
+            return it->second.layout;
+        }
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = setCount;
+    pipelineLayoutInfo.pSetLayouts = setLayoutHandles.data();
+    pipelineLayoutInfo.pushConstantRangeCount = range.stageFlags != 0 ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = &range;
+
+    VkPipelineLayout layout;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout for " + name + "!");
+    }
+
+    pipelineLayouts.emplace(hash, CachedPipelineLayout{ setLayoutHandles, range, layout });
+
+    return layout;
+}
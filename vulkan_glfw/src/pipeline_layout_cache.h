@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader_reflection.h"
+
+// Descriptor set layouts and pipeline layouts made from shader reflection. Every request is hashed over everything the
+// layout is created from and looked up first, so pipelines whose shaders declare the same resources share one layout
+// and shader variants add no layouts of their own. The cache owns the layouts it hands out.
+class PipelineLayoutCache {
+public:
+    // a set whose layout is owned elsewhere, like the uniform ring's; the bindings the shaders declare in it are
+    // checked against the bindings it was created with instead of generating a layout
+    struct ExternalSetLayout {
+        uint32_t set;
+        VkDescriptorSetLayout layout;
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+    };
+
+    explicit PipelineLayoutCache(VkDevice device);
+    ~PipelineLayoutCache();
+
+    PipelineLayoutCache(const PipelineLayoutCache&) = delete;
+    PipelineLayoutCache& operator=(const PipelineLayoutCache&) = delete;
+
+    // name identifies the pipeline in errors. Sets below the highest one that no shader uses get an empty layout.
+    VkPipelineLayout getPipelineLayout(const ShaderReflection& reflection, const std::vector<ExternalSetLayout>& externalSetLayouts, const std::string& name);
+
+    VkDescriptorSetLayout getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+    uint32_t getDescriptorSetLayoutCount() const { return static_cast<uint32_t>(setLayouts.size()); }
+    uint32_t getPipelineLayoutCount() const { return static_cast<uint32_t>(pipelineLayouts.size()); }
+    // requests answered with a layout created for an earlier one
+    uint32_t getHitCount() const { return hitCount; }
+
+private:
+    struct CachedSetLayout {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        VkDescriptorSetLayout layout;
+    };
+
+    struct CachedPipelineLayout {
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        VkPushConstantRange pushConstantRange;
+        VkPipelineLayout layout;
+    };
+
+    VkDevice device;
+
+    // by hash; a hash collision only costs a comparison
+    std::unordered_multimap<uint64_t, CachedSetLayout> setLayouts;
+    std::unordered_multimap<uint64_t, CachedPipelineLayout> pipelineLayouts;
+    uint32_t hitCount = 0;
+};
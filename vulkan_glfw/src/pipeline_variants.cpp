@@ -0,0 +1,471 @@
+#include "pipeline_variants.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+// FNV-1a over the state a variant is created from
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+static void hashValue(uint64_t& hash, uint64_t value) {
+    for (uint32_t i = 0; i < sizeof(value); i++) {
+        hash = (hash ^ ((value >> (i * 8)) & 0xff)) * FNV_PRIME;
+    }
+}
+
+static VkShaderModule createShaderModule(VkDevice device, std::span<const uint32_t> code) {
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size_bytes();
+    createInfo.pCode = code.data();
+
+    VkShaderModule shaderModule;
+
+    if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module!");
+    }
+
+    return shaderModule;
+}
+
+static VkPipelineColorBlendAttachmentState getBlendAttachment(PipelineVariantCache::BlendMode blendMode) {
+    VkPipelineColorBlendAttachmentState attachment{};
+    attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    attachment.blendEnable = blendMode != PipelineVariantCache::BlendMode::Opaque;
+    attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    attachment.dstColorBlendFactor = blendMode == PipelineVariantCache::BlendMode::Additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    return attachment;
+}
+
+// the constants are laid out one after the other, constant_id i at offset i * 4
+static std::vector<VkSpecializationMapEntry> getSpecializationMapEntries(const std::vector<uint32_t>& constants) {
+    std::vector<VkSpecializationMapEntry> mapEntries(constants.size());
+
+    for (uint32_t i = 0; i < mapEntries.size(); i++) {
+        mapEntries[i].constantID = i;
+        mapEntries[i].offset = i * sizeof(uint32_t);
+        mapEntries[i].size = sizeof(uint32_t);
+    }
+
+    return mapEntries;
+}
+
+bool PipelineVariantCache::isGraphicsPipelineLibrarySupported(VkPhysicalDevice physicalDevice) {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const char* requiredExtension : getGraphicsPipelineLibraryExtensions()) {
+        bool isFound = false;
+
+        for (const auto& extension : availableExtensions) {
+            if (std::strcmp(extension.extensionName, requiredExtension) == 0) {
+                isFound = true;
+                break;
+            }
+        }
+
+        if (!isFound) {
+            return false;
+        }
+    }
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures{};
+    libraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &libraryFeatures;
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return libraryFeatures.graphicsPipelineLibrary;
+}
+
+const std::vector<const char*>& PipelineVariantCache::getGraphicsPipelineLibraryExtensions() {
+    // graphics pipeline libraries are built on pipeline libraries
+    static const std::vector<const char*> extensions = {
+        VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+        VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME
+    };
+
+    return extensions;
+}
+
+VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT PipelineVariantCache::getGraphicsPipelineLibraryFeatures() {
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    features.graphicsPipelineLibrary = VK_TRUE;
+
+    return features;
+}
+
+uint64_t PipelineVariantCache::getHash(const Variant& variant) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    hashValue(hash, static_cast<uint32_t>(variant.blendMode));
+    hashValue(hash, variant.fragmentConstants.size());
+
+    for (uint32_t constant : variant.fragmentConstants) {
+        hashValue(hash, constant);
+    }
+
+    return hash;
+}
+
+PipelineVariantCache::PipelineVariantCache(VkDevice device, VkPipelineCache pipelineCache, const VkGraphicsPipelineCreateInfo& baseInfo, std::span<const uint32_t> vertexShaderCode, std::span<const uint32_t> fragmentShaderCode, uint32_t threadCount, bool useGraphicsPipelineLibrary) :
+    device(device),
+    pipelineCache(pipelineCache),
+    baseInfo(baseInfo),
+    useGraphicsPipelineLibrary(useGraphicsPipelineLibrary) {
+    vertexShaderModule = createShaderModule(device, vertexShaderCode);
+    fragmentShaderModule = createShaderModule(device, fragmentShaderCode);
+
+    if (useGraphicsPipelineLibrary) {
+        VkGraphicsPipelineCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        vertexInputInfo.pVertexInputState = baseInfo.pVertexInputState;
+        vertexInputInfo.pInputAssemblyState = baseInfo.pInputAssemblyState;
+        vertexInputInfo.pDynamicState = baseInfo.pDynamicState;
+
+        vertexInputLibrary = createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, vertexInputInfo);
+
+        VkPipelineShaderStageCreateInfo vertexStage{};
+        vertexStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vertexStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+        vertexStage.module = vertexShaderModule;
+        vertexStage.pName = "main";
+
+        VkGraphicsPipelineCreateInfo preRasterizationInfo{};
+        preRasterizationInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        preRasterizationInfo.stageCount = 1;
+        preRasterizationInfo.pStages = &vertexStage;
+        preRasterizationInfo.pViewportState = baseInfo.pViewportState;
+        preRasterizationInfo.pRasterizationState = baseInfo.pRasterizationState;
+        preRasterizationInfo.pDynamicState = baseInfo.pDynamicState;
+        preRasterizationInfo.layout = baseInfo.layout;
+        preRasterizationInfo.renderPass = baseInfo.renderPass;
+        preRasterizationInfo.subpass = baseInfo.subpass;
+
+        preRasterizationLibrary = createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, preRasterizationInfo);
+    }
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&PipelineVariantCache::run, this);
+    }
+}
+
+PipelineVariantCache::~PipelineVariantCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+
+    jobAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (auto& entry : entries) {
+        vkDestroyPipeline(device, entry->pipeline, nullptr);
+        vkDestroyPipeline(device, entry->fastLinkedPipeline, nullptr);
+    }
+
+    for (auto& [constants, library] : fragmentShaderLibraries) {
+        vkDestroyPipeline(device, library, nullptr);
+    }
+
+    for (auto& [blendMode, library] : fragmentOutputLibraries) {
+        vkDestroyPipeline(device, library, nullptr);
+    }
+
+    vkDestroyPipeline(device, preRasterizationLibrary, nullptr);
+    vkDestroyPipeline(device, vertexInputLibrary, nullptr);
+
+    vkDestroyShaderModule(device, fragmentShaderModule, nullptr);
+    vkDestroyShaderModule(device, vertexShaderModule, nullptr);
+}
+
+uint32_t PipelineVariantCache::add(const Variant& variant) {
+    uint64_t hash = getHash(variant);
+
+    auto [first, last] = entryIds.equal_range(hash);
+
+    for (auto it = first; it != last; ++it) {
+        if (entries[it->second]->variant == variant) {
+            return it->second;
+        }
+    }
+
+    uint32_t id = static_cast<uint32_t>(entries.size());
+
+    auto entry = std::make_unique<Entry>();
+    entry->variant = variant;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (entries.empty()) {
+            firstAddTime = std::chrono::steady_clock::now();
+        }
+
+        jobs.push_back(Job{ entry.get(), false });
+        entries.push_back(std::move(entry));
+    }
+
+    entryIds.emplace(hash, id);
+    jobAvailable.notify_one();
+
+    return id;
+}
+
+double PipelineVariantCache::getAllReadyMilliseconds() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (entries.empty() || readyCount + failureCount < entries.size()) {
+        return -1.0;
+    }
+
+    return std::chrono::duration<double, std::milli>(lastReadyTime - firstAddTime).count();
+}
+
+void PipelineVariantCache::run() {
+    while (true) {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this] { return isStopping || !jobs.empty(); });
+
+            if (isStopping) {
+                return;
+            }
+
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        compile(job);
+    }
+}
+
+void PipelineVariantCache::compile(const Job& job) {
+    Entry& entry = *job.entry;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    try {
+        pipeline = useGraphicsPipelineLibrary ? linkPipeline(entry.variant, job.isOptimizing) : createPipeline(entry.variant);
+    } catch (const std::exception& e) {
+        std::cerr << "[variants] " << e.what() << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (job.isOptimizing) {
+        // the fast-linked pipeline stays usable when the optimized link fails
+        if (pipeline != VK_NULL_HANDLE) {
+            entry.fastLinkedPipeline = entry.pipeline.exchange(pipeline, std::memory_order_acq_rel);
+        }
+
+        return;
+    }
+
+    if (pipeline == VK_NULL_HANDLE) {
+        failureCount++;
+    } else {
+        entry.pipeline.store(pipeline, std::memory_order_release);
+        readyCount++;
+
+        // the variant can be drawn with now; the optimized pipeline replaces it once it is linked
+        if (useGraphicsPipelineLibrary) {
+            jobs.push_back(Job{ job.entry, true });
+            jobAvailable.notify_one();
+        }
+    }
+
+    lastReadyTime = std::chrono::steady_clock::now();
+}
+
+VkPipeline PipelineVariantCache::createPipeline(const Variant& variant) {
+    auto mapEntries = getSpecializationMapEntries(variant.fragmentConstants);
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+    specializationInfo.pMapEntries = mapEntries.data();
+    specializationInfo.dataSize = variant.fragmentConstants.size() * sizeof(uint32_t);
+    specializationInfo.pData = variant.fragmentConstants.data();
+
+    VkPipelineShaderStageCreateInfo stages[2]{};
+
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertexShaderModule;
+    stages[0].pName = "main";
+
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragmentShaderModule;
+    stages[1].pName = "main";
+    stages[1].pSpecializationInfo = &specializationInfo;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = getBlendAttachment(variant.blendMode);
+
+    VkPipelineColorBlendStateCreateInfo colorBlending = *baseInfo.pColorBlendState;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &blendAttachment;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = baseInfo;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = stages;
+    pipelineInfo.pColorBlendState = &colorBlending;
+
+    VkPipeline pipeline;
+
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline variant!");
+    }
+
+    return pipeline;
+}
+
+VkPipeline PipelineVariantCache::linkPipeline(const Variant& variant, bool isOptimized) {
+    VkPipeline libraries[] = {
+        vertexInputLibrary,
+        preRasterizationLibrary,
+        getFragmentShaderLibrary(variant.fragmentConstants),
+        getFragmentOutputLibrary(variant.blendMode)
+    };
+
+    VkPipelineLibraryCreateInfoKHR linkInfo{};
+    linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    linkInfo.libraryCount = 4;
+    linkInfo.pLibraries = libraries;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &linkInfo;
+    pipelineInfo.flags = isOptimized ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    pipelineInfo.layout = baseInfo.layout;
+
+    VkPipeline pipeline;
+
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to link pipeline variant!");
+    }
+
+    return pipeline;
+}
+
+VkPipeline PipelineVariantCache::createLibrary(VkGraphicsPipelineLibraryFlagsEXT parts, VkGraphicsPipelineCreateInfo libraryInfo) {
+    // the rendering info of dynamic rendering, if any, is needed by every part but the vertex input
+    VkGraphicsPipelineLibraryCreateInfoEXT partsInfo{};
+    partsInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    partsInfo.pNext = baseInfo.pNext;
+    partsInfo.flags = parts;
+
+    libraryInfo.pNext = &partsInfo;
+    // keeps what the optimized link needs
+    libraryInfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+    VkPipeline library;
+
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &libraryInfo, nullptr, &library) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline library!");
+    }
+
+    return library;
+}
+
+VkPipeline PipelineVariantCache::getFragmentShaderLibrary(const std::vector<uint32_t>& constants) {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        auto it = fragmentShaderLibraries.find(constants);
+
+        if (it != fragmentShaderLibraries.end()) {
+            return it->second;
+        }
+    }
+
+    auto mapEntries = getSpecializationMapEntries(constants);
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+    specializationInfo.pMapEntries = mapEntries.data();
+    specializationInfo.dataSize = constants.size() * sizeof(uint32_t);
+    specializationInfo.pData = constants.data();
+
+    VkPipelineShaderStageCreateInfo fragmentStage{};
+    fragmentStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragmentStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragmentStage.module = fragmentShaderModule;
+    fragmentStage.pName = "main";
+    fragmentStage.pSpecializationInfo = &specializationInfo;
+
+    VkGraphicsPipelineCreateInfo fragmentShaderInfo{};
+    fragmentShaderInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    fragmentShaderInfo.stageCount = 1;
+    fragmentShaderInfo.pStages = &fragmentStage;
+    fragmentShaderInfo.pMultisampleState = baseInfo.pMultisampleState;
+    fragmentShaderInfo.pDepthStencilState = baseInfo.pDepthStencilState;
+    fragmentShaderInfo.pDynamicState = baseInfo.pDynamicState;
+    fragmentShaderInfo.layout = baseInfo.layout;
+    fragmentShaderInfo.renderPass = baseInfo.renderPass;
+    fragmentShaderInfo.subpass = baseInfo.subpass;
+
+    VkPipeline library = createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, fragmentShaderInfo);
+
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    auto [it, isInserted] = fragmentShaderLibraries.emplace(constants, library);
+
+    if (!isInserted) {
+        vkDestroyPipeline(device, library, nullptr);
+    }
+
+    return it->second;
+}
+
+VkPipeline PipelineVariantCache::getFragmentOutputLibrary(BlendMode blendMode) {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        auto it = fragmentOutputLibraries.find(blendMode);
+
+        if (it != fragmentOutputLibraries.end()) {
+            return it->second;
+        }
+    }
+
+    VkPipelineColorBlendAttachmentState blendAttachment = getBlendAttachment(blendMode);
+
+    VkPipelineColorBlendStateCreateInfo colorBlending = *baseInfo.pColorBlendState;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &blendAttachment;
+
+    VkGraphicsPipelineCreateInfo fragmentOutputInfo{};
+    fragmentOutputInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    fragmentOutputInfo.pColorBlendState = &colorBlending;
+    fragmentOutputInfo.pMultisampleState = baseInfo.pMultisampleState;
+    fragmentOutputInfo.pDynamicState = baseInfo.pDynamicState;
+    fragmentOutputInfo.renderPass = baseInfo.renderPass;
+    fragmentOutputInfo.subpass = baseInfo.subpass;
+
+    VkPipeline library = createLibrary(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, fragmentOutputInfo);
+
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    auto [it, isInserted] = fragmentOutputLibraries.emplace(blendMode, library);
+
+    if (!isInserted) {
+        vkDestroyPipeline(device, library, nullptr);
+    }
+
+    return it->second;
+}
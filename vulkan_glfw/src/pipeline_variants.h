@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Variants of a graphics pipeline that differ in their blend mode and in the specialization constants of the fragment
+// shader. Each variant is keyed by a hash of that state and compiled on a pool of worker threads through the shared
+// VkPipelineCache, never on the render thread; until it is ready the caller draws with a fallback pipeline.
+//
+// With VK_EXT_graphics_pipeline_library the pipeline is built from four libraries: the vertex input and the
+// pre-rasterization library are shared by all variants, fragment shader libraries are made per set of constants and
+// fragment output libraries per blend mode. A new variant mostly links libraries that already exist, which is fast; it
+// is relinked with link-time optimization in the background afterwards.
+class PipelineVariantCache {
+public:
+    enum class BlendMode : uint32_t {
+        Opaque,
+        Alpha,
+        Additive
+    };
+
+    struct Variant {
+        BlendMode blendMode = BlendMode::Opaque;
+        // 32-bit values of the fragment shader's specialization constants, by constant_id
+        std::vector<uint32_t> fragmentConstants;
+
+        bool operator==(const Variant& other) const = default;
+    };
+
+    static bool isGraphicsPipelineLibrarySupported(VkPhysicalDevice physicalDevice);
+
+    // to be enabled on the device, with getGraphicsPipelineLibraryFeatures() in the VkDeviceCreateInfo pNext chain
+    static const std::vector<const char*>& getGraphicsPipelineLibraryExtensions();
+    static VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT getGraphicsPipelineLibraryFeatures();
+
+    // every variant is created like baseInfo with its own stages and blend state, so everything else baseInfo points
+    // to, its pNext chain included, must outlive the cache. The shaders get modules of their own.
+    PipelineVariantCache(VkDevice device, VkPipelineCache pipelineCache, const VkGraphicsPipelineCreateInfo& baseInfo, std::span<const uint32_t> vertexShaderCode, std::span<const uint32_t> fragmentShaderCode, uint32_t threadCount, bool useGraphicsPipelineLibrary);
+    ~PipelineVariantCache();
+
+    PipelineVariantCache(const PipelineVariantCache&) = delete;
+    PipelineVariantCache& operator=(const PipelineVariantCache&) = delete;
+
+    // the id of the variant, queued for compilation the first time it is added; a variant added before gets its id back
+    uint32_t add(const Variant& variant);
+
+    // VK_NULL_HANDLE while the variant is compiled; never blocks. The pipeline returned stays valid until the cache is
+    // destroyed, even when an optimized one replaces it.
+    VkPipeline getPipeline(uint32_t id) const { return entries[id]->pipeline.load(std::memory_order_acquire); }
+
+    bool usesGraphicsPipelineLibrary() const { return useGraphicsPipelineLibrary; }
+    uint32_t getVariantCount() const { return static_cast<uint32_t>(entries.size()); }
+    uint32_t getReadyCount() const { return readyCount; }
+    uint32_t getFailureCount() const { return failureCount; }
+    // from the first add() until every variant added was ready, or -1 while some are still compiled
+    double getAllReadyMilliseconds() const;
+
+    static uint64_t getHash(const Variant& variant);
+
+private:
+    struct Entry {
+        Variant variant;
+        std::atomic<VkPipeline> pipeline = VK_NULL_HANDLE;
+        // replaced by the optimized link, but frames in flight may still use it
+        VkPipeline fastLinkedPipeline = VK_NULL_HANDLE;
+    };
+
+    struct Job {
+        Entry* entry;
+        // relink the fast-linked pipeline with link-time optimization
+        bool isOptimizing;
+    };
+
+    void run();
+    void compile(const Job& job);
+
+    VkPipeline createPipeline(const Variant& variant);
+    VkPipeline linkPipeline(const Variant& variant, bool isOptimized);
+    VkPipeline createLibrary(VkGraphicsPipelineLibraryFlagsEXT parts, VkGraphicsPipelineCreateInfo libraryInfo);
+    VkPipeline getFragmentShaderLibrary(const std::vector<uint32_t>& constants);
+    VkPipeline getFragmentOutputLibrary(BlendMode blendMode);
+
+    VkDevice device;
+    VkPipelineCache pipelineCache;
+    VkGraphicsPipelineCreateInfo baseInfo;
+    VkShaderModule vertexShaderModule = VK_NULL_HANDLE;
+    VkShaderModule fragmentShaderModule = VK_NULL_HANDLE;
+    bool useGraphicsPipelineLibrary;
+
+    // shared by every variant
+    VkPipeline vertexInputLibrary = VK_NULL_HANDLE;
+    VkPipeline preRasterizationLibrary = VK_NULL_HANDLE;
+
+    // two workers may create the same library at once; the one that loses destroys its own
+    std::mutex libraryMutex;
+    std::map<std::vector<uint32_t>, VkPipeline> fragmentShaderLibraries;
+    std::map<BlendMode, VkPipeline> fragmentOutputLibraries;
+
+    // entries are only added by the render thread; the workers keep pointers to them
+    std::vector<std::unique_ptr<Entry>> entries;
+    // by hash; a hash collision only costs a comparison
+    std::unordered_multimap<uint64_t, uint32_t> entryIds;
+
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<Job> jobs;
+    bool isStopping = false;
+
+    std::chrono::steady_clock::time_point firstAddTime;
+    std::chrono::steady_clock::time_point lastReadyTime;
+    std::atomic<uint32_t> readyCount = 0;
+    std::atomic<uint32_t> failureCount = 0;
+
+    std::vector<std::thread> workers;
+};
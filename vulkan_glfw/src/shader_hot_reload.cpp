@@ -0,0 +1,382 @@
+#include "shader_hot_reload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+// a save often touches a file more than once (or several files), so a rebuild waits until nothing changed for this long
+static constexpr std::chrono::milliseconds QUIET_PERIOD(100);
+// how often the worker checks whether it should stop, and how often the modification times are polled without inotify
+static constexpr std::chrono::milliseconds POLL_INTERVAL(250);
+
+// runs arguments[0] with the rest as its arguments and collects what it prints to stdout and stderr; true when it
+// exited with 0
+static bool runProcess(const std::vector<std::string>& arguments, std::string& output) {
+#ifdef _WIN32
+    std::string command;
+
+    for (const auto& argument : arguments) {
+        command += (command.empty() ? "\"" : " \"") + argument + "\"";
+    }
+
+    // cmd /c strips the first and the last quote of a command with more than two, so the whole command gets a pair of
+    // its own
+    FILE* pipe = popen(("\"" + command + " 2>&1\"").c_str(), "r");
+
+    if (pipe == nullptr) {
+        return false;
+    }
+
+    char buffer[256];
+
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        output += buffer;
+    }
+
+    return pclose(pipe) == 0;
+#else
+    // no shell in between, so paths with spaces or quotes reach the compiler as they are
+    int fds[2];
+
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    // the render thread may start processes too; they must not inherit the pipe
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO);
+
+    std::vector<char*> argv;
+
+    for (const auto& argument : arguments) {
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    int result = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    if (result != 0) {
+        close(fds[0]);
+        return false;
+    }
+
+    char buffer[256];
+    ssize_t count;
+
+    while ((count = read(fds[0], buffer, sizeof(buffer))) != 0) {
+        if (count > 0) {
+            output.append(buffer, count);
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+
+    close(fds[0]);
+
+    int status;
+
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+ShaderHotReload::ShaderHotReload(VkDevice device, std::filesystem::path compiler, std::filesystem::path sourceDirectory, std::filesystem::path outputDirectory, std::vector<Shader> shaders, BuildFunction build) :
+    device(device),
+    compiler(std::move(compiler)),
+    sourceDirectory(std::move(sourceDirectory)),
+    outputDirectory(std::move(outputDirectory)),
+    shaders(std::move(shaders)),
+    build(std::move(build)) {
+    std::error_code error;
+    std::filesystem::create_directories(this->outputDirectory, error);
+
+    if (error) {
+        throw std::runtime_error("failed to create hot reload output directory: " + error.message() + "!");
+    }
+
+#ifdef __linux__
+    watchDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    // editors either write the file in place or rename a new one over it
+    if (watchDescriptor != -1 && inotify_add_watch(watchDescriptor, this->sourceDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        close(watchDescriptor);
+        watchDescriptor = -1;
+    }
+#endif
+
+    if (watchDescriptor == -1) {
+        lastModification = getNewestModification();
+    }
+
+    std::string shaderNames;
+
+    for (const auto& shader : this->shaders) {
+        shaderNames += (shaderNames.empty() ? "" : ", ") + shader.sourceName;
+    }
+
+    std::cout << "[hot reload] watching " << this->sourceDirectory.string() << (watchDescriptor == -1 ? " (polling)" : " (inotify)") << ", changes rebuild the pipeline of " << shaderNames << std::endl;
+
+    worker = std::thread(&ShaderHotReload::run, this);
+}
+
+ShaderHotReload::~ShaderHotReload() {
+    isStopping = true;
+    worker.join();
+
+    // built but never handed out, so the GPU has not used it
+    if (pendingPipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, pendingPipeline, nullptr);
+    }
+
+#ifdef __linux__
+    if (watchDescriptor != -1) {
+        close(watchDescriptor);
+    }
+#endif
+}
+
+VkPipeline ShaderHotReload::takePipeline() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    VkPipeline pipeline = pendingPipeline;
+    pendingPipeline = VK_NULL_HANDLE;
+
+    return pipeline;
+}
+
+void ShaderHotReload::run() {
+    while (waitForChange()) {
+        rebuild();
+    }
+}
+
+bool ShaderHotReload::waitForChange() {
+    bool isChanged = false;
+
+#ifdef __linux__
+    if (watchDescriptor != -1) {
+        alignas(inotify_event) char events[4096];
+
+        while (!isStopping) {
+            pollfd watchPoll{};
+            watchPoll.fd = watchDescriptor;
+            watchPoll.events = POLLIN;
+
+            int ready = poll(&watchPoll, 1, static_cast<int>((isChanged ? QUIET_PERIOD : POLL_INTERVAL).count()));
+
+            if (ready == 0 && isChanged) {
+                return true;
+            }
+
+            if (ready <= 0) {
+                continue;
+            }
+
+            ssize_t size;
+
+            while ((size = read(watchDescriptor, events, sizeof(events))) > 0) {
+                for (char* it = events; it < events + size;) {
+                    auto event = reinterpret_cast<const inotify_event*>(it);
+
+                    if (event->len > 0 && isShaderSource(event->name)) {
+                        isChanged = true;
+                    }
+
+                    it += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+
+        return false;
+    }
+#endif
+
+    while (!isStopping) {
+        std::this_thread::sleep_for(isChanged ? QUIET_PERIOD : POLL_INTERVAL);
+
+        auto newestModification = getNewestModification();
+
+        if (newestModification != lastModification) {
+            lastModification = newestModification;
+            isChanged = true;
+        } else if (isChanged) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ShaderHotReload::isShaderSource(const std::filesystem::path& path) const {
+    auto name = path.filename().string();
+
+    // editors' swap files are hidden
+    if (name.empty() || name.front() == '.') {
+        return false;
+    }
+
+    auto extension = path.extension();
+
+    return extension == ".vert" || extension == ".frag" || extension == ".comp" || extension == ".glsl";
+}
+
+std::filesystem::file_time_type ShaderHotReload::getNewestModification() const {
+    std::filesystem::file_time_type newestModification{};
+    std::error_code error;
+
+    for (const auto& entry : std::filesystem::directory_iterator(sourceDirectory, error)) {
+        if (isShaderSource(entry.path())) {
+            newestModification = std::max(newestModification, entry.last_write_time(error));
+        }
+    }
+
+    return newestModification;
+}
+
+void ShaderHotReload::rebuild() {
+    auto compileStart = std::chrono::steady_clock::now();
+
+    std::vector<std::vector<uint32_t>> codes(shaders.size());
+
+    for (size_t i = 0; i < shaders.size(); i++) {
+        if (!compile(shaders[i], codes[i])) {
+            failureCount++;
+            return;
+        }
+    }
+
+    auto buildStart = std::chrono::steady_clock::now();
+
+    std::vector<VkShaderModule> shaderModules;
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+
+    for (size_t i = 0; i < shaders.size(); i++) {
+        VkShaderModuleCreateInfo shaderInfo{};
+        shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        shaderInfo.codeSize = codes[i].size() * sizeof(uint32_t);
+        shaderInfo.pCode = codes[i].data();
+
+        VkShaderModule shaderModule;
+
+        if (vkCreateShaderModule(device, &shaderInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            break;
+        }
+
+        shaderModules.push_back(shaderModule);
+
+        VkPipelineShaderStageCreateInfo stage{};
+        stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stage.stage = shaders[i].stage;
+        stage.module = shaderModule;
+        stage.pName = "main";
+
+        stages.push_back(stage);
+    }
+
+    VkPipeline pipeline = stages.size() == shaders.size() ? build(stages, codes) : VK_NULL_HANDLE;
+
+    for (auto shaderModule : shaderModules) {
+        vkDestroyShaderModule(device, shaderModule, nullptr);
+    }
+
+    if (pipeline == VK_NULL_HANDLE) {
+        std::cerr << "[hot reload] Failed to create the pipeline, keeping the current one" << std::endl;
+        failureCount++;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // the render thread has not picked the previous one up yet, so it was never used
+        if (pendingPipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, pendingPipeline, nullptr);
+        }
+
+        pendingPipeline = pipeline;
+    }
+
+    reloadCount++;
+
+    auto buildEnd = std::chrono::steady_clock::now();
+
+    std::cout << "[hot reload] pipeline rebuilt: shaders compiled in " << std::chrono::duration<double, std::milli>(buildStart - compileStart).count()
+              << " ms, pipeline created in " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count() << " ms" << std::endl;
+}
+
+bool ShaderHotReload::compile(const Shader& shader, std::vector<uint32_t>& code) {
+    auto sourcePath = sourceDirectory / shader.sourceName;
+    auto outputPath = outputDirectory / (sourcePath.stem().string() + "_" + sourcePath.extension().string().substr(1) + ".spv");
+
+    std::vector<std::string> arguments = { compiler.string(), "-O", "-I", sourceDirectory.string(), sourcePath.string(), "-o", outputPath.string() };
+    std::string output;
+
+    if (!runProcess(arguments, output)) {
+        std::cerr << "[hot reload] Failed to compile " << shader.sourceName << ", keeping the current pipeline:\n" << output << std::flush;
+        return false;
+    }
+
+    std::ifstream file(outputPath, std::ios::ate | std::ios::binary);
+
+    if (!file.is_open()) {
+        std::cerr << "[hot reload] Failed to open " << outputPath.string() << std::endl;
+        return false;
+    }
+
+    size_t fileSize = (size_t)file.tellg();
+
+    // a truncated file would be read past the end of the code
+    if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0) {
+        std::cerr << "[hot reload] " << outputPath.string() << " is not SPIR-V (" << fileSize << " bytes), keeping the current pipeline" << std::endl;
+        return false;
+    }
+
+    code.resize(fileSize / sizeof(uint32_t));
+
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(code.data()), fileSize);
+
+    if (!file.good()) {
+        std::cerr << "[hot reload] Failed to read " << outputPath.string() << ", keeping the current pipeline" << std::endl;
+        return false;
+    }
+
+    return true;
+}
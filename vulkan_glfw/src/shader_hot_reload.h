@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rebuilds a graphics pipeline when the GLSL sources of its shaders change. A worker thread watches the source
+// directory (inotify on Linux, polling the modification times elsewhere), compiles the shaders with glslc once the
+// files have been quiet for a moment, and creates the new pipeline, so neither the compiler nor the driver ever runs on
+// the render thread. A shader that fails to compile is logged and the current pipeline stays.
+//
+// The render thread picks the new pipeline up between frames; the pipeline it replaces may still be used by frames in
+// flight and has to be retired by the caller.
+class ShaderHotReload {
+public:
+    struct Shader {
+        // in the source directory, e.g. shader.vert
+        std::string sourceName;
+        VkShaderStageFlagBits stage;
+    };
+
+    // creates the pipeline from the compiled stages, or returns VK_NULL_HANDLE, e.g. when the SPIR-V (codes, in the
+    // order of the stages) no longer fits the pipeline layout; runs on the worker thread, so it may only use what stays
+    // unchanged while the hot reload exists
+    using BuildFunction = std::function<VkPipeline(std::span<const VkPipelineShaderStageCreateInfo> stages, std::span<const std::vector<uint32_t>> codes)>;
+
+    // changes to any shader source in sourceDirectory rebuild the pipeline, since the shaders may #include it; the
+    // compiled SPIR-V is written to outputDirectory
+    ShaderHotReload(VkDevice device, std::filesystem::path compiler, std::filesystem::path sourceDirectory, std::filesystem::path outputDirectory, std::vector<Shader> shaders, BuildFunction build);
+    ~ShaderHotReload();
+
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+    // the pipeline built since the last call, or VK_NULL_HANDLE; never blocks for a rebuild in progress
+    VkPipeline takePipeline();
+
+    uint32_t getReloadCount() const { return reloadCount; }
+    uint32_t getFailureCount() const { return failureCount; }
+
+private:
+    void run();
+    // blocks until a shader source changed and the files have been quiet for a moment; false once stopping
+    bool waitForChange();
+    bool isShaderSource(const std::filesystem::path& path) const;
+    std::filesystem::file_time_type getNewestModification() const;
+
+    void rebuild();
+    // glslc's output is logged when it fails
+    bool compile(const Shader& shader, std::vector<uint32_t>& code);
+
+    VkDevice device;
+    std::filesystem::path compiler;
+    std::filesystem::path sourceDirectory;
+    std::filesystem::path outputDirectory;
+    std::vector<Shader> shaders;
+    BuildFunction build;
+
+    // the inotify descriptor, or -1 when polling
+    int watchDescriptor = -1;
+    std::filesystem::file_time_type lastModification;
+
+    std::mutex mutex;
+    VkPipeline pendingPipeline = VK_NULL_HANDLE;
+
+    std::atomic<bool> isStopping = false;
+    std::atomic<uint32_t> reloadCount = 0;
+    std::atomic<uint32_t> failureCount = 0;
+
+    std::thread worker;
+};
@@ -0,0 +1,569 @@
+#include "shader_reflection.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// the parts of the SPIR-V specification the reflection reads
+static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+static constexpr uint32_t SPIRV_HEADER_WORDS = 5;
+
+static constexpr uint32_t OP_NAME = 5;
+static constexpr uint32_t OP_ENTRY_POINT = 15;
+static constexpr uint32_t OP_TYPE_INT = 21;
+static constexpr uint32_t OP_TYPE_FLOAT = 22;
+static constexpr uint32_t OP_TYPE_VECTOR = 23;
+static constexpr uint32_t OP_TYPE_MATRIX = 24;
+static constexpr uint32_t OP_TYPE_IMAGE = 25;
+static constexpr uint32_t OP_TYPE_SAMPLER = 26;
+static constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+static constexpr uint32_t OP_TYPE_ARRAY = 28;
+static constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+static constexpr uint32_t OP_TYPE_STRUCT = 30;
+static constexpr uint32_t OP_TYPE_POINTER = 32;
+static constexpr uint32_t OP_CONSTANT = 43;
+static constexpr uint32_t OP_VARIABLE = 59;
+static constexpr uint32_t OP_DECORATE = 71;
+static constexpr uint32_t OP_MEMBER_DECORATE = 72;
+
+static constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+static constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+static constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+static constexpr uint32_t DECORATION_BUILT_IN = 11;
+static constexpr uint32_t DECORATION_LOCATION = 30;
+static constexpr uint32_t DECORATION_BINDING = 33;
+static constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+static constexpr uint32_t DECORATION_OFFSET = 35;
+
+static constexpr uint32_t STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+static constexpr uint32_t STORAGE_CLASS_INPUT = 1;
+static constexpr uint32_t STORAGE_CLASS_UNIFORM = 2;
+static constexpr uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+static constexpr uint32_t STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+static constexpr uint32_t DIM_BUFFER = 5;
+static constexpr uint32_t DIM_SUBPASS_DATA = 6;
+
+// an id with the instruction that defined it and what it was decorated with
+struct SpirvId {
+    uint32_t opcode = 0;
+    // operands after the result id; a variable's and a constant's start with their type
+    std::vector<uint32_t> operands;
+    std::string name;
+
+    bool isBuiltIn = false;
+    bool isBufferBlock = false;
+    uint32_t location = UINT32_MAX;
+    uint32_t binding = UINT32_MAX;
+    uint32_t set = 0;
+    uint32_t arrayStride = 0;
+
+    // struct members
+    std::vector<uint32_t> memberOffsets;
+    std::vector<uint32_t> memberMatrixStrides;
+    bool hasBuiltInMember = false;
+};
+
+class SpirvModule {
+public:
+    explicit SpirvModule(std::span<const uint32_t> code);
+
+    VkShaderStageFlags stages = 0;
+    std::vector<uint32_t> variables;
+
+    const SpirvId& get(uint32_t id) const;
+    // the type a pointer, variable or constant refers to
+    const SpirvId& getPointee(uint32_t pointerTypeId) const;
+    uint32_t getConstant(uint32_t id) const;
+    uint32_t getSize(uint32_t typeId, uint32_t matrixStride = 0) const;
+
+private:
+    SpirvId& at(uint32_t id);
+
+    std::vector<SpirvId> ids;
+};
+
+static VkShaderStageFlags getStage(uint32_t executionModel) {
+    switch (executionModel) {
+    case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+    default: throw std::runtime_error("failed to reflect shader: unsupported execution model!");
+    }
+}
+
+SpirvModule::SpirvModule(std::span<const uint32_t> code) {
+    if (code.size() < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC) {
+        throw std::runtime_error("failed to reflect shader: not SPIR-V!");
+    }
+
+    // every id is below the bound
+    ids.resize(code[3]);
+
+    for (size_t i = SPIRV_HEADER_WORDS; i < code.size();) {
+        uint32_t wordCount = code[i] >> 16;
+        uint32_t opcode = code[i] & 0xffff;
+
+        if (wordCount == 0 || i + wordCount > code.size()) {
+            throw std::runtime_error("failed to reflect shader: truncated instruction!");
+        }
+
+        auto words = code.subspan(i, wordCount);
+
+        switch (opcode) {
+        case OP_NAME: {
+            // a nul-terminated string packed into the remaining words
+            auto text = reinterpret_cast<const char*>(words.data() + 2);
+            at(words[1]).name.assign(text, std::find(text, text + (wordCount - 2) * sizeof(uint32_t), '\0'));
+            break;
+        }
+        case OP_ENTRY_POINT:
+            stages |= getStage(words[1]);
+            break;
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_IMAGE:
+        case OP_TYPE_SAMPLER:
+        case OP_TYPE_SAMPLED_IMAGE:
+        case OP_TYPE_ARRAY:
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_TYPE_STRUCT:
+        case OP_TYPE_POINTER: {
+            SpirvId& type = at(words[1]);
+            type.opcode = opcode;
+            type.operands.assign(words.begin() + 2, words.end());
+
+            if (opcode == OP_TYPE_STRUCT) {
+                type.memberOffsets.resize(type.operands.size());
+                type.memberMatrixStrides.resize(type.operands.size());
+            }
+
+            break;
+        }
+        case OP_CONSTANT:
+        case OP_VARIABLE: {
+            SpirvId& value = at(words[2]);
+            value.opcode = opcode;
+            value.operands = { words[1], words[3] };
+
+            if (opcode == OP_VARIABLE) {
+                variables.push_back(words[2]);
+            }
+
+            break;
+        }
+        case OP_DECORATE: {
+            SpirvId& target = at(words[1]);
+            uint32_t value = wordCount > 3 ? words[3] : 0;
+
+            switch (words[2]) {
+            case DECORATION_BUFFER_BLOCK: target.isBufferBlock = true; break;
+            case DECORATION_ARRAY_STRIDE: target.arrayStride = value; break;
+            case DECORATION_BUILT_IN: target.isBuiltIn = true; break;
+            case DECORATION_LOCATION: target.location = value; break;
+            case DECORATION_BINDING: target.binding = value; break;
+            case DECORATION_DESCRIPTOR_SET: target.set = value; break;
+            }
+
+            break;
+        }
+        case OP_MEMBER_DECORATE: {
+            // decorations come before the types they decorate
+            SpirvId& target = at(words[1]);
+            uint32_t member = words[2];
+            uint32_t value = wordCount > 4 ? words[4] : 0;
+
+            if (member >= target.memberOffsets.size()) {
+                target.memberOffsets.resize(member + 1);
+                target.memberMatrixStrides.resize(member + 1);
+            }
+
+            switch (words[3]) {
+            case DECORATION_OFFSET: target.memberOffsets[member] = value; break;
+            case DECORATION_MATRIX_STRIDE: target.memberMatrixStrides[member] = value; break;
+            case DECORATION_BUILT_IN: target.hasBuiltInMember = true; break;
+            }
+
+            break;
+        }
+        }
+
+        i += wordCount;
+    }
+}
+
+SpirvId& SpirvModule::at(uint32_t id) {
+    if (id >= ids.size()) {
+        throw std::runtime_error("failed to reflect shader: id out of bounds!");
+    }
+
+    return ids[id];
+}
+
+const SpirvId& SpirvModule::get(uint32_t id) const {
+    if (id >= ids.size() || ids[id].opcode == 0) {
+        throw std::runtime_error("failed to reflect shader: undefined id!");
+    }
+
+    return ids[id];
+}
+
+const SpirvId& SpirvModule::getPointee(uint32_t pointerTypeId) const {
+    const SpirvId& pointer = get(pointerTypeId);
+
+    if (pointer.opcode != OP_TYPE_POINTER) {
+        throw std::runtime_error("failed to reflect shader: variable is not a pointer!");
+    }
+
+    return get(pointer.operands[1]);
+}
+
+uint32_t SpirvModule::getConstant(uint32_t id) const {
+    const SpirvId& constant = get(id);
+
+    // array lengths from specialization constants are not known until the pipeline is created
+    if (constant.opcode != OP_CONSTANT) {
+        throw std::runtime_error("failed to reflect shader: array length is not a constant!");
+    }
+
+    return constant.operands[1];
+}
+
+uint32_t SpirvModule::getSize(uint32_t typeId, uint32_t matrixStride) const {
+    const SpirvId& type = get(typeId);
+
+    switch (type.opcode) {
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+        return type.operands[0] / 8;
+    case OP_TYPE_VECTOR:
+        return type.operands[1] * getSize(type.operands[0]);
+    case OP_TYPE_MATRIX:
+        return type.operands[1] * (matrixStride != 0 ? matrixStride : getSize(type.operands[0]));
+    case OP_TYPE_ARRAY:
+        return getConstant(type.operands[1]) * (type.arrayStride != 0 ? type.arrayStride : getSize(type.operands[0]));
+    case OP_TYPE_STRUCT: {
+        uint32_t size = 0;
+
+        for (size_t i = 0; i < type.operands.size(); i++) {
+            size = std::max(size, type.memberOffsets[i] + getSize(type.operands[i], type.memberMatrixStrides[i]));
+        }
+
+        return size;
+    }
+    default:
+        throw std::runtime_error("failed to reflect shader: push constant member has no size!");
+    }
+}
+
+// the 32- and 64-bit formats, by component count
+static VkFormat getVertexFormat(const SpirvId& componentType, uint32_t componentCount) {
+    static constexpr VkFormat FLOAT_FORMATS[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static constexpr VkFormat DOUBLE_FORMATS[] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+    static constexpr VkFormat INT_FORMATS[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static constexpr VkFormat UINT_FORMATS[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+    uint32_t width = componentType.operands[0];
+
+    if (componentCount < 1 || componentCount > 4) {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    if (componentType.opcode == OP_TYPE_FLOAT && width == 32) {
+        return FLOAT_FORMATS[componentCount - 1];
+    }
+
+    if (componentType.opcode == OP_TYPE_FLOAT && width == 64) {
+        return DOUBLE_FORMATS[componentCount - 1];
+    }
+
+    if (componentType.opcode == OP_TYPE_INT && width == 32) {
+        return componentType.operands[1] != 0 ? INT_FORMATS[componentCount - 1] : UINT_FORMATS[componentCount - 1];
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+static void reflectVertexInput(const SpirvModule& module, const SpirvId& variable, ShaderReflection& reflection) {
+    const SpirvId& type = module.getPointee(variable.operands[0]);
+
+    if (variable.isBuiltIn || type.hasBuiltInMember) {
+        return;
+    }
+
+    if (variable.location == UINT32_MAX) {
+        throw std::runtime_error("failed to reflect shader: vertex input " + variable.name + " has no location!");
+    }
+
+    // a matrix takes one location per column
+    const SpirvId& columnType = type.opcode == OP_TYPE_MATRIX ? module.get(type.operands[0]) : type;
+    uint32_t columnCount = type.opcode == OP_TYPE_MATRIX ? type.operands[1] : 1;
+
+    const SpirvId& componentType = columnType.opcode == OP_TYPE_VECTOR ? module.get(columnType.operands[0]) : columnType;
+    uint32_t componentCount = columnType.opcode == OP_TYPE_VECTOR ? columnType.operands[1] : 1;
+
+    if (componentType.opcode != OP_TYPE_FLOAT && componentType.opcode != OP_TYPE_INT) {
+        throw std::runtime_error("failed to reflect shader: vertex input " + variable.name + " has an unsupported type!");
+    }
+
+    VkFormat format = getVertexFormat(componentType, componentCount);
+
+    if (format == VK_FORMAT_UNDEFINED) {
+        throw std::runtime_error("failed to reflect shader: vertex input " + variable.name + " has no vertex format!");
+    }
+
+    for (uint32_t column = 0; column < columnCount; column++) {
+        reflection.vertexInputs.push_back(ShaderReflection::VertexInput{ variable.location + column, format, componentCount * componentType.operands[0] / 8, variable.name });
+    }
+}
+
+static void reflectDescriptorBinding(const SpirvModule& module, const SpirvId& variable, uint32_t storageClass, ShaderReflection& reflection) {
+    const SpirvId* type = &module.getPointee(variable.operands[0]);
+    uint32_t count = 1;
+
+    // arrays of descriptors, the outermost runtime-sized for bindless
+    while (type->opcode == OP_TYPE_ARRAY || type->opcode == OP_TYPE_RUNTIME_ARRAY) {
+        count = type->opcode == OP_TYPE_RUNTIME_ARRAY ? 0 : count * module.getConstant(type->operands[1]);
+        type = &module.get(type->operands[0]);
+    }
+
+    VkDescriptorType descriptorType;
+
+    switch (type->opcode) {
+    case OP_TYPE_SAMPLER:
+        descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        break;
+    case OP_TYPE_SAMPLED_IMAGE:
+        descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        break;
+    case OP_TYPE_IMAGE: {
+        // sampled type, dim, depth, arrayed, multisampled, sampled (1: with a sampler, 2: storage), format
+        uint32_t dim = type->operands[1];
+        bool isStorage = type->operands[5] == 2;
+
+        if (dim == DIM_SUBPASS_DATA) {
+            descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        } else if (dim == DIM_BUFFER) {
+            descriptorType = isStorage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        } else {
+            descriptorType = isStorage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+
+        break;
+    }
+    case OP_TYPE_STRUCT:
+        // before SPIR-V 1.3, storage buffers were uniform blocks decorated BufferBlock
+        descriptorType = storageClass == STORAGE_CLASS_STORAGE_BUFFER || type->isBufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        break;
+    default:
+        throw std::runtime_error("failed to reflect shader: " + variable.name + " has an unsupported descriptor type!");
+    }
+
+    if (variable.binding == UINT32_MAX) {
+        throw std::runtime_error("failed to reflect shader: " + variable.name + " has no binding!");
+    }
+
+    // blocks are often declared without an instance name
+    const std::string& name = variable.name.empty() ? type->name : variable.name;
+
+    reflection.descriptorBindings.push_back(ShaderReflection::DescriptorBinding{ variable.set, variable.binding, descriptorType, count, module.stages, name });
+}
+
+static void reflectPushConstants(const SpirvModule& module, const SpirvId& variable, ShaderReflection& reflection) {
+    uint32_t blockTypeId = module.get(variable.operands[0]).operands[1];
+    const SpirvId& block = module.get(blockTypeId);
+
+    if (block.opcode != OP_TYPE_STRUCT || block.operands.empty()) {
+        throw std::runtime_error("failed to reflect shader: push constants are not a block!");
+    }
+
+    // members may start at an offset, leaving the bytes in front to other stages
+    uint32_t offset = *std::min_element(block.memberOffsets.begin(), block.memberOffsets.end());
+
+    reflection.pushConstantRange.stageFlags = module.stages;
+    reflection.pushConstantRange.offset = offset;
+    reflection.pushConstantRange.size = module.getSize(blockTypeId) - offset;
+}
+
+ShaderReflection ShaderReflection::reflect(std::span<const uint32_t> code) {
+    SpirvModule module(code);
+    ShaderReflection reflection;
+    reflection.stages = module.stages;
+
+    for (uint32_t id : module.variables) {
+        const SpirvId& variable = module.get(id);
+        uint32_t storageClass = variable.operands[1];
+
+        switch (storageClass) {
+        case STORAGE_CLASS_INPUT:
+            if (module.stages & VK_SHADER_STAGE_VERTEX_BIT) {
+                reflectVertexInput(module, variable, reflection);
+            }
+
+            break;
+        case STORAGE_CLASS_UNIFORM_CONSTANT:
+        case STORAGE_CLASS_UNIFORM:
+        case STORAGE_CLASS_STORAGE_BUFFER:
+            reflectDescriptorBinding(module, variable, storageClass, reflection);
+            break;
+        case STORAGE_CLASS_PUSH_CONSTANT:
+            reflectPushConstants(module, variable, reflection);
+            break;
+        }
+    }
+
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const VertexInput& a, const VertexInput& b) {
+        return a.location < b.location;
+    });
+
+    std::sort(reflection.descriptorBindings.begin(), reflection.descriptorBindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+
+    return reflection;
+}
+
+void ShaderReflection::merge(const ShaderReflection& other) {
+    stages |= other.stages;
+
+    for (const auto& input : other.vertexInputs) {
+        auto it = std::lower_bound(vertexInputs.begin(), vertexInputs.end(), input.location, [](const VertexInput& a, uint32_t location) {
+            return a.location < location;
+        });
+
+        if (it == vertexInputs.end() || it->location != input.location) {
+            vertexInputs.insert(it, input);
+        }
+    }
+
+    for (const auto& binding : other.descriptorBindings) {
+        auto it = std::lower_bound(descriptorBindings.begin(), descriptorBindings.end(), binding, [](const DescriptorBinding& a, const DescriptorBinding& b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        });
+
+        if (it == descriptorBindings.end() || it->set != binding.set || it->binding != binding.binding) {
+            descriptorBindings.insert(it, binding);
+        } else if (it->type != binding.type || it->count != binding.count) {
+            throw std::runtime_error("failed to merge shader reflections: stages disagree on set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + "!");
+        } else {
+            it->stages |= binding.stages;
+        }
+    }
+
+    if (other.pushConstantRange.stageFlags == 0) {
+        return;
+    }
+
+    if (pushConstantRange.stageFlags == 0) {
+        pushConstantRange = other.pushConstantRange;
+        return;
+    }
+
+    uint32_t end = std::max(pushConstantRange.offset + pushConstantRange.size, other.pushConstantRange.offset + other.pushConstantRange.size);
+
+    pushConstantRange.stageFlags |= other.pushConstantRange.stageFlags;
+    pushConstantRange.offset = std::min(pushConstantRange.offset, other.pushConstantRange.offset);
+    pushConstantRange.size = end - pushConstantRange.offset;
+}
+
+uint32_t ShaderReflection::getSetCount() const {
+    return descriptorBindings.empty() ? 0 : descriptorBindings.back().set + 1;
+}
+
+std::vector<VkDescriptorSetLayoutBinding> ShaderReflection::getSetLayoutBindings(uint32_t set) const {
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+
+    for (const auto& binding : descriptorBindings) {
+        if (binding.set == set) {
+            layoutBindings.push_back(VkDescriptorSetLayoutBinding{ binding.binding, binding.type, binding.count, binding.stages, nullptr });
+        }
+    }
+
+    return layoutBindings;
+}
+
+void validateVertexInput(const ShaderReflection& reflection, std::span<const VkVertexInputBindingDescription> bindings, std::span<const VkVertexInputAttributeDescription> attributes, const std::string& name) {
+    for (const auto& input : reflection.vertexInputs) {
+        std::string inputName = name + " input " + input.name + " (location " + std::to_string(input.location) + ")";
+
+        auto attribute = std::find_if(attributes.begin(), attributes.end(), [&](const VkVertexInputAttributeDescription& a) { return a.location == input.location; });
+
+        if (attribute == attributes.end()) {
+            throw std::runtime_error(inputName + " has no vertex attribute!");
+        }
+
+        if (attribute->format != input.format) {
+            throw std::runtime_error(inputName + " is format " + std::to_string(input.format) + ", but its vertex attribute is format " + std::to_string(attribute->format) + "!");
+        }
+
+        auto binding = std::find_if(bindings.begin(), bindings.end(), [&](const VkVertexInputBindingDescription& b) { return b.binding == attribute->binding; });
+
+        if (binding == bindings.end()) {
+            throw std::runtime_error(inputName + " reads vertex binding " + std::to_string(attribute->binding) + ", which does not exist!");
+        }
+
+        if (attribute->offset + input.size > binding->stride) {
+            throw std::runtime_error(inputName + " reads past the stride of vertex binding " + std::to_string(binding->binding) + "!");
+        }
+    }
+}
+
+void validatePushConstants(const ShaderReflection& reflection, size_t pushConstantsSize, const std::string& name) {
+    const auto& range = reflection.pushConstantRange;
+
+    if (range.stageFlags != 0 && range.offset + range.size > pushConstantsSize) {
+        throw std::runtime_error(name + " push constants take " + std::to_string(range.offset + range.size) + " bytes, but the pushed struct has " + std::to_string(pushConstantsSize) + "!");
+    }
+}
+
+void validatePushConstantRange(const ShaderReflection& reflection, const VkPushConstantRange& layoutRange, const std::string& name) {
+    const auto& range = reflection.pushConstantRange;
+
+    if (range.stageFlags == 0) {
+        return;
+    }
+
+    if ((layoutRange.stageFlags & range.stageFlags) != range.stageFlags) {
+        throw std::runtime_error(name + " push constants are used by stages the pipeline layout's range does not include!");
+    }
+
+    if (range.offset < layoutRange.offset || range.offset + range.size > layoutRange.offset + layoutRange.size) {
+        throw std::runtime_error(name + " push constants take bytes " + std::to_string(range.offset) + " to " + std::to_string(range.offset + range.size) + ", outside the pipeline layout's range!");
+    }
+}
+
+void validateDescriptorSetLayout(const ShaderReflection& reflection, uint32_t set, std::span<const VkDescriptorSetLayoutBinding> layoutBindings, const std::string& name) {
+    for (const auto& binding : reflection.descriptorBindings) {
+        if (binding.set != set) {
+            continue;
+        }
+
+        std::string bindingName = name + " " + binding.name + " (set " + std::to_string(set) + ", binding " + std::to_string(binding.binding) + ")";
+
+        auto layoutBinding = std::find_if(layoutBindings.begin(), layoutBindings.end(), [&](const VkDescriptorSetLayoutBinding& b) { return b.binding == binding.binding; });
+
+        if (layoutBinding == layoutBindings.end()) {
+            throw std::runtime_error(bindingName + " is not in the descriptor set layout!");
+        }
+
+        bool isTypeCompatible = layoutBinding->descriptorType == binding.type
+            || (binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && layoutBinding->descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+            || (binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && layoutBinding->descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
+
+        if (!isTypeCompatible) {
+            throw std::runtime_error(bindingName + " is descriptor type " + std::to_string(binding.type) + ", but the layout has type " + std::to_string(layoutBinding->descriptorType) + "!");
+        }
+
+        if (layoutBinding->descriptorCount < std::max(binding.count, 1u)) {
+            throw std::runtime_error(bindingName + " needs more descriptors than the layout has!");
+        }
+
+        if ((layoutBinding->stageFlags & binding.stages) != binding.stages) {
+            throw std::runtime_error(bindingName + " is not visible to every stage that uses it!");
+        }
+    }
+}
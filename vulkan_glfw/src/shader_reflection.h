@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// What a SPIR-V module expects from the pipeline: the vertex inputs of a vertex shader, the descriptor bindings and the
+// push constant range, read straight from the module's declarations and decorations. The stages of a pipeline are
+// merged into one reflection, which its layout is made from (src/pipeline_layout_cache.h).
+struct ShaderReflection {
+    struct VertexInput {
+        uint32_t location;
+        VkFormat format;
+        // bytes read from the vertex buffer
+        uint32_t size;
+        std::string name;
+    };
+
+    struct DescriptorBinding {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType type;
+        // 0 for a runtime-sized array
+        uint32_t count;
+        VkShaderStageFlags stages;
+        std::string name;
+    };
+
+    VkShaderStageFlags stages = 0;
+    // sorted by location
+    std::vector<VertexInput> vertexInputs;
+    // sorted by set, then binding
+    std::vector<DescriptorBinding> descriptorBindings;
+    // stageFlags is 0 when no stage has push constants
+    VkPushConstantRange pushConstantRange{};
+
+    // throws when the module is not valid SPIR-V or declares something a pipeline layout cannot express
+    static ShaderReflection reflect(std::span<const uint32_t> code);
+
+    // adds the stages of another module of the same pipeline. Bindings both use must agree on their type and count.
+    // The push constant ranges become one range for all stages that have push constants, so a single
+    // vkCmdPushConstants updates them all.
+    void merge(const ShaderReflection& other);
+
+    // one past the highest set a binding is in
+    uint32_t getSetCount() const;
+    std::vector<VkDescriptorSetLayoutBinding> getSetLayoutBindings(uint32_t set) const;
+};
+
+// the checks throw a std::runtime_error naming the shader (name) and what does not match
+
+// every input the vertex shader reads must be provided by an attribute of the same format, which must fit the stride
+// of its binding; attributes the shader does not read are allowed
+void validateVertexInput(const ShaderReflection& reflection, std::span<const VkVertexInputBindingDescription> bindings, std::span<const VkVertexInputAttributeDescription> attributes, const std::string& name);
+
+// the push constants the shaders declare must fit the C++ struct that is pushed
+void validatePushConstants(const ShaderReflection& reflection, size_t pushConstantsSize, const std::string& name);
+
+// the push constants the shaders declare must lie in the layout's range, which must include every stage that has some
+void validatePushConstantRange(const ShaderReflection& reflection, const VkPushConstantRange& layoutRange, const std::string& name);
+
+// every binding the shaders declare in the set must exist in the layout, with a compatible type (a dynamic buffer
+// for a buffer), enough descriptors and all the stages that use it
+void validateDescriptorSetLayout(const ShaderReflection& reflection, uint32_t set, std::span<const VkDescriptorSetLayoutBinding> layoutBindings, const std::string& name);
@@ -0,0 +1,60 @@
+#include "startup_profiler.h"
+
+#include <iomanip>
+#include <iostream>
+
+StartupProfiler::StartupProfiler() :
+    launchTime(Clock::now()),
+    phaseStart(launchTime) {
+}
+
+void StartupProfiler::beginPhase(const std::string& name) {
+    if (hasPresentedFrame) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+
+    endPhase(now);
+
+    currentPhase = name;
+    phaseStart = now;
+}
+
+void StartupProfiler::markFirstPresent() {
+    if (hasPresentedFrame) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+
+    endPhase(now);
+
+    totalMilliseconds = std::chrono::duration<double, std::milli>(now - launchTime).count();
+    hasPresentedFrame = true;
+}
+
+void StartupProfiler::endPhase(Clock::time_point now) {
+    if (currentPhase.empty()) {
+        return;
+    }
+
+    phases.push_back(Phase{ currentPhase, std::chrono::duration<double, std::milli>(now - phaseStart).count() });
+    currentPhase.clear();
+}
+
+void StartupProfiler::print() const {
+    std::ios oldState(nullptr);
+    oldState.copyfmt(std::cout);
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (const auto& phase : phases) {
+        std::cout << "[startup] " << std::left << std::setw(16) << phase.name << std::right << std::setw(10) << phase.milliseconds << " ms"
+                  << " (" << std::setprecision(1) << phase.milliseconds * 100.0 / totalMilliseconds << "%)" << std::setprecision(3) << std::endl;
+    }
+
+    std::cout << "[startup] launch to first present: " << totalMilliseconds << " ms" << std::endl;
+
+    std::cout.copyfmt(oldState);
+}
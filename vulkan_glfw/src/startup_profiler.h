@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Times startup from the beginning of main() to the first frame on screen, as a sequence of named phases. A phase
+// runs until the next one begins, so the phases add up to the total.
+class StartupProfiler {
+public:
+    struct Phase {
+        std::string name;
+        double milliseconds;
+    };
+
+    // starts the clock
+    StartupProfiler();
+
+    // ends the current phase, if any
+    void beginPhase(const std::string& name);
+
+    // ends the last phase; everything after it is no longer startup
+    void markFirstPresent();
+
+    bool hasPresented() const { return hasPresentedFrame; }
+
+    const std::vector<Phase>& getPhases() const { return phases; }
+    double getTotalMilliseconds() const { return totalMilliseconds; }
+
+    // one [startup] line per phase and one for the total
+    void print() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void endPhase(Clock::time_point now);
+
+    Clock::time_point launchTime;
+    Clock::time_point phaseStart;
+    std::string currentPhase;
+
+    std::vector<Phase> phases;
+    double totalMilliseconds = 0.0;
+    bool hasPresentedFrame = false;
+};
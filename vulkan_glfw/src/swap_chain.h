@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+struct SwapChainSupportDetails {
+    VkSurfaceCapabilitiesKHR capabilities;
+    std::vector<VkSurfaceFormatKHR> formats;
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
+
+VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
+VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, bool preferUncapped);
+VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int framebufferWidth, int framebufferHeight);
+
+// everything that stays the same when the swap chain is recreated
+struct SwapChainSettings {
+    VkSurfaceKHR surface;
+    VkSurfaceFormatKHR surfaceFormat;
+    VkPresentModeKHR presentMode;
+    uint32_t graphicsQueueFamilyIndex;
+    uint32_t presentationQueueFamilyIndex;
+    // VK_NULL_HANDLE with dynamic rendering, in which case no framebuffers are created
+    VkRenderPass renderPass;
+};
+
+// The swap chain together with everything that depends on its images.
+struct SwapChain {
+    VkSwapchainKHR handle = VK_NULL_HANDLE;
+    VkExtent2D extent{};
+    VkImageUsageFlags imageUsage = 0;
+    std::vector<VkImage> images;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkFramebuffer> framebuffers;
+
+    // the presentation engine holds on to renderFinished until the image is presented,
+    // so these are owned by the swap chain image rather than by the frame slot
+    std::vector<VkSemaphore> renderFinishedSemaphores;
+};
+
+// Creates a swap chain for the current surface size. Passing the previous handle as oldSwapChain retires it,
+// so images already acquired from it can still be presented; it must be destroyed by the caller once the
+// frames using it have completed. Returns false (and creates nothing) while the surface has a zero extent,
+// e.g. when the window is minimized.
+bool createSwapChain(VkDevice device, VkPhysicalDevice physicalDevice, const SwapChainSettings& settings, int framebufferWidth, int framebufferHeight, VkSwapchainKHR oldSwapChain, SwapChain& swapChain);
+
+void destroySwapChain(VkDevice device, SwapChain& swapChain);
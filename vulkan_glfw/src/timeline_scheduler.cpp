@@ -0,0 +1,125 @@
+#include "timeline_scheduler.h"
+
+#include <stdexcept>
+
+bool TimelineScheduler::isSupported(VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    if (properties.apiVersion < VK_API_VERSION_1_2) {
+        return false;
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &timelineFeatures;
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return timelineFeatures.timelineSemaphore;
+}
+
+VkPhysicalDeviceTimelineSemaphoreFeatures TimelineScheduler::getRequiredFeatures() {
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+
+    return timelineFeatures;
+}
+
+TimelineScheduler::TimelineScheduler(VkDevice device) :
+    device(device) {
+    VkSemaphoreTypeCreateInfo semaphoreTypeInfo{};
+    semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &semaphoreTypeInfo;
+
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+}
+
+TimelineScheduler::~TimelineScheduler() {
+    vkDestroySemaphore(device, semaphore, nullptr);
+}
+
+VkResult TimelineScheduler::submit(VkQueue queue, const VkSubmitInfo& submitInfo, uint64_t& signalValue, const std::vector<Wait>& timelineWaits) {
+    // timelines go after the batch's own semaphores; the values given for binary semaphores are ignored
+    waitSemaphores.assign(submitInfo.pWaitSemaphores, submitInfo.pWaitSemaphores + submitInfo.waitSemaphoreCount);
+    waitStageMasks.assign(submitInfo.pWaitDstStageMask, submitInfo.pWaitDstStageMask + submitInfo.waitSemaphoreCount);
+    waitValues.assign(waitSemaphores.size(), 0);
+
+    for (const auto& wait : timelineWaits) {
+        waitSemaphores.push_back(wait.timeline->semaphore);
+        waitStageMasks.push_back(wait.stageMask);
+        waitValues.push_back(wait.value);
+    }
+
+    signalSemaphores.assign(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+    signalSemaphores.push_back(semaphore);
+
+    signalValues.assign(signalSemaphores.size(), 0);
+    signalValues.back() = submittedValue + 1;
+
+    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+    timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineSubmitInfo.pNext = submitInfo.pNext;
+    timelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+    timelineSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+    timelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+    timelineSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+
+    VkSubmitInfo timelineSubmit = submitInfo;
+    timelineSubmit.pNext = &timelineSubmitInfo;
+    timelineSubmit.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    timelineSubmit.pWaitSemaphores = waitSemaphores.data();
+    timelineSubmit.pWaitDstStageMask = waitStageMasks.data();
+    timelineSubmit.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+    timelineSubmit.pSignalSemaphores = signalSemaphores.data();
+
+    VkResult result = vkQueueSubmit(queue, 1, &timelineSubmit, VK_NULL_HANDLE);
+
+    if (result == VK_SUCCESS) {
+        signalValue = ++submittedValue;
+    }
+
+    return result;
+}
+
+bool TimelineScheduler::isComplete(uint64_t value) {
+    if (value > completedValue) {
+        vkGetSemaphoreCounterValue(device, semaphore, &completedValue);
+    }
+
+    return value <= completedValue;
+}
+
+void TimelineScheduler::wait(uint64_t value) {
+    if (value <= completedValue) {
+        return;
+    }
+
+    // nothing would ever signal it
+    if (value > submittedValue) {
+        throw std::runtime_error("waiting for a timeline value that was never submitted!");
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &semaphore;
+    waitInfo.pValues = &value;
+
+    if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+        throw std::runtime_error("failed to wait for timeline semaphore!");
+    }
+
+    completedValue = value;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+// One timeline semaphore that every submission signals with the next value of a single counter, so frames, upload
+// batches and the readbacks recorded into frames all complete along the same timeline. Whatever the GPU may still be
+// using remembers the value of the last submission that used it and is released once the completed value reaches it.
+// The CPU waits for exactly the value it needs instead of for one fence per submission.
+//
+// Values must be signaled in increasing order, so each queue has a timeline of its own; a submission to one queue can
+// wait for a value on another queue's timeline.
+class TimelineScheduler {
+public:
+    struct Wait {
+        const TimelineScheduler* timeline;
+        uint64_t value;
+        VkPipelineStageFlags stageMask;
+    };
+
+    // timeline semaphores are core in Vulkan 1.2
+    static bool isSupported(VkPhysicalDevice physicalDevice);
+
+    // to be chained into the VkDeviceCreateInfo pNext chain
+    static VkPhysicalDeviceTimelineSemaphoreFeatures getRequiredFeatures();
+
+    explicit TimelineScheduler(VkDevice device);
+    ~TimelineScheduler();
+
+    TimelineScheduler(const TimelineScheduler&) = delete;
+    TimelineScheduler& operator=(const TimelineScheduler&) = delete;
+
+    // submits the batch without a fence, additionally signaling the timeline; signalValue is set to the value it
+    // signals. The batch's own wait and signal semaphores must be binary, timelineWaits are added to its waits.
+    VkResult submit(VkQueue queue, const VkSubmitInfo& submitInfo, uint64_t& signalValue, const std::vector<Wait>& timelineWaits = {});
+
+    // value of the most recent submission, which completes after everything submitted before it
+    uint64_t getSubmittedValue() const { return submittedValue; }
+
+    // only queries the semaphore when the last known completed value is not enough
+    bool isComplete(uint64_t value);
+
+    // returns immediately when value has already completed
+    void wait(uint64_t value);
+
+private:
+    VkDevice device;
+    VkSemaphore semaphore;
+
+    uint64_t submittedValue = 0;
+    uint64_t completedValue = 0;
+
+    // reused by every submit
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitStageMasks;
+    std::vector<uint64_t> waitValues;
+    std::vector<VkSemaphore> signalSemaphores;
+    std::vector<uint64_t> signalValues;
+};
@@ -0,0 +1,110 @@
+#include "uniform_ring.h"
+
+#include <stdexcept>
+
+UniformRing::UniformRing(VkDevice device, VkPhysicalDevice physicalDevice, DeviceMemoryAllocator& allocator, VkDeviceSize blockSize, uint32_t blocksPerSlot, VkShaderStageFlags stages, uint32_t slotCount) :
+    device(device),
+    allocator(allocator),
+    blocksPerSlot(blocksPerSlot) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    if (blockSize > properties.limits.maxUniformBufferRange) {
+        throw std::runtime_error("uniform ring block size exceeds maxUniformBufferRange!");
+    }
+
+    // the alignment limit is a power of two
+    VkDeviceSize alignment = properties.limits.minUniformBufferOffsetAlignment;
+    VkDeviceSize alignedBlockSize = (blockSize + alignment - 1) & ~(alignment - 1);
+    VkDeviceSize bufferSize = alignedBlockSize * blocksPerSlot * slotCount;
+
+    // dynamic offsets are 32 bits
+    if (bufferSize > UINT32_MAX) {
+        throw std::runtime_error("uniform ring is too large for dynamic offsets!");
+    }
+
+    blockStride = static_cast<uint32_t>(alignedBlockSize);
+
+    createBuffer(device, allocator, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, bufferAllocation);
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = stages;
+
+    layoutBindings = { binding };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create uniform ring descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create uniform ring descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate uniform ring descriptor set!");
+    }
+
+    // written once; the dynamic offset moves the range around at bind time
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = blockSize;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+UniformRing::~UniformRing() {
+    // destroying the pool frees the set
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+    destroyBuffer(device, allocator, buffer, bufferAllocation);
+}
+
+void UniformRing::beginFrame(uint32_t slot) {
+    slotBegin = blockStride * blocksPerSlot * slot;
+    slotBlocks = 0;
+}
+
+uint32_t UniformRing::allocate(uint32_t blockCount) {
+    if (blockCount > blocksPerSlot - slotBlocks) {
+        throw std::runtime_error("uniform ring slot is full!");
+    }
+
+    uint32_t offset = slotBegin + blockStride * slotBlocks;
+    slotBlocks += blockCount;
+
+    return offset;
+}
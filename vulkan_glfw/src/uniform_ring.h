@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "memory_allocator.h"
+
+// Persistently mapped uniform buffer with one region per frame slot, allocated linearly in fixed-size blocks and reset
+// as a whole when the slot comes around again. A single descriptor set with a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+// binding covers one block; the block is picked with a dynamic offset when the set is bound, so per-draw data needs
+// neither descriptor updates nor allocations while recording.
+class UniformRing {
+public:
+    // blockSize is the size of the uniform block the shader sees; stages are the shader stages that read it
+    UniformRing(VkDevice device, VkPhysicalDevice physicalDevice, DeviceMemoryAllocator& allocator, VkDeviceSize blockSize, uint32_t blocksPerSlot, VkShaderStageFlags stages, uint32_t slotCount);
+    ~UniformRing();
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    // what the layout was created with, to check shaders against
+    const std::vector<VkDescriptorSetLayoutBinding>& getDescriptorSetLayoutBindings() const { return layoutBindings; }
+    VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+
+    // block size rounded up to minUniformBufferOffsetAlignment
+    uint32_t getBlockStride() const { return blockStride; }
+
+    // the slot's previous frame must have completed
+    void beginFrame(uint32_t slot);
+
+    // returns the dynamic offset of the first of blockCount consecutive blocks in the current slot's region
+    uint32_t allocate(uint32_t blockCount);
+
+    void* getMappedData(uint32_t dynamicOffset) const { return static_cast<char*>(bufferAllocation.mappedData) + dynamicOffset; }
+
+private:
+    VkDevice device;
+    DeviceMemoryAllocator& allocator;
+    uint32_t blockStride;
+    uint32_t blocksPerSlot;
+
+    VkBuffer buffer;
+    Allocation bufferAllocation;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+
+    uint32_t slotBegin = 0;
+    uint32_t slotBlocks = 0;
+};
@@ -0,0 +1,478 @@
+#include "upload_queue.h"
+
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr VkDeviceSize RING_ALIGNMENT = 16;
+
+// everything that may read uploaded data on the queue that uses it
+static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+static constexpr VkAccessFlags CONSUMER_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool UploadHandle::isReady() const {
+    return queue == nullptr || queue->isComplete(ticket);
+}
+
+void UploadHandle::wait() const {
+    if (queue != nullptr) {
+        queue->wait(ticket);
+    }
+}
+
+UploadQueue::UploadQueue(VkDevice device, DeviceMemoryAllocator& allocator, TimelineScheduler& timeline, VkQueue queue, uint32_t queueFamilyIndex, const TransferQueue* transferQueue, VkDeviceSize capacity) :
+    device(device),
+    allocator(allocator),
+    timeline(timeline),
+    queue(queue),
+    queueFamilyIndex(queueFamilyIndex),
+    capacity(capacity) {
+    VkCommandPoolCreateInfo commandPoolCreateInfo{};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+    if (vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    if (transferQueue) {
+        this->transferQueue = *transferQueue;
+        commandPoolCreateInfo.queueFamilyIndex = transferQueue->queueFamilyIndex;
+
+        if (vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &transferCommandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create transfer command pool!");
+        }
+    }
+
+    createBuffer(device, allocator, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, ringBuffer, ringAllocation);
+}
+
+UploadQueue::~UploadQueue() {
+    if (!inFlightBatches.empty()) {
+        timeline.wait(inFlightBatches.back().timelineValue);
+    }
+
+    while (!inFlightBatches.empty()) {
+        retireOldest();
+    }
+
+    for (auto& staging : pendingOversizedStaging) {
+        destroyBuffer(device, allocator, staging.buffer, staging.allocation);
+    }
+
+    vkDestroyCommandPool(device, commandPool, nullptr);
+
+    if (hasTransferQueue()) {
+        vkDestroyCommandPool(device, transferCommandPool, nullptr);
+    }
+
+    destroyBuffer(device, allocator, ringBuffer, ringAllocation);
+}
+
+bool UploadQueue::allocateRing(VkDeviceSize size, VkDeviceSize& offset) {
+    // nothing is pending or in flight: start over from the beginning of the ring
+    if (pendingCopies.empty() && pendingImageCopies.empty() && inFlightBatches.empty()) {
+        head = 0;
+        tail = 0;
+    }
+
+    VkDeviceSize alignedHead = alignUp(head, RING_ALIGNMENT);
+
+    // free space is [head, capacity) + [0, tail); head may only touch tail when the ring is empty
+    if (head >= tail) {
+        if (alignedHead + size <= capacity) {
+            offset = alignedHead;
+            head = alignedHead + size;
+            return true;
+        }
+
+        if (size < tail) {
+            offset = 0;
+            head = size;
+            return true;
+        }
+
+        return false;
+    }
+
+    // free space is [head, tail)
+    if (alignedHead + size < tail) {
+        offset = alignedHead;
+        head = alignedHead + size;
+        return true;
+    }
+
+    return false;
+}
+
+void UploadQueue::stage(const void* data, VkDeviceSize size, VkBuffer& srcBuffer, VkDeviceSize& srcOffset) {
+    if (size > capacity / 2) {
+        // too big for the ring; give it a staging buffer of its own that lives as long as the batch
+        OversizedStaging staging;
+        createBuffer(device, allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, staging.allocation);
+
+        memcpy(staging.allocation.mappedData, data, static_cast<size_t>(size));
+
+        pendingOversizedStaging.push_back(staging);
+
+        srcBuffer = staging.buffer;
+        srcOffset = 0;
+        return;
+    }
+
+    while (!allocateRing(size, srcOffset)) {
+        // the ring is full: make sure the data occupying it is submitted, then wait for the oldest batch
+        poll();
+
+        if (inFlightBatches.empty()) {
+            flush();
+        }
+
+        if (!inFlightBatches.empty()) {
+            timeline.wait(inFlightBatches.front().timelineValue);
+            retireOldest();
+        }
+    }
+
+    memcpy(static_cast<char*>(ringAllocation.mappedData) + srcOffset, data, static_cast<size_t>(size));
+
+    srcBuffer = ringBuffer;
+}
+
+UploadHandle UploadQueue::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+    VkBufferCopy region{};
+    region.dstOffset = dstOffset;
+    region.size = size;
+
+    VkBuffer srcBuffer;
+    stage(data, size, srcBuffer, region.srcOffset);
+
+    pendingCopies.push_back(PendingCopy{ srcBuffer, dstBuffer, region });
+    pendingBytes += size;
+
+    return UploadHandle(this, ++lastTicket);
+}
+
+UploadHandle UploadQueue::uploadImage(VkImage dstImage, VkExtent2D extent, const void* data, VkDeviceSize size) {
+    VkBufferImageCopy region{};
+    region.bufferRowLength = 0; // tightly packed
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { extent.width, extent.height, 1 };
+
+    VkBuffer srcBuffer;
+    stage(data, size, srcBuffer, region.bufferOffset);
+
+    pendingImageCopies.push_back(PendingImageCopy{ srcBuffer, dstImage, region });
+    pendingBytes += size;
+
+    return UploadHandle(this, ++lastTicket);
+}
+
+UploadQueue::Batch UploadQueue::acquireBatch() {
+    poll();
+
+    if (!freeBatches.empty()) {
+        Batch batch = std::move(freeBatches.back());
+        freeBatches.pop_back();
+
+        vkResetCommandBuffer(batch.commandBuffer, 0);
+
+        if (hasTransferQueue()) {
+            vkResetCommandBuffer(batch.acquireCommandBuffer, 0);
+        }
+
+        return batch;
+    }
+
+    Batch batch{};
+
+    if (hasTransferQueue()) {
+        batch.commandBuffer = allocateCommandBuffer(transferCommandPool);
+        batch.acquireCommandBuffer = allocateCommandBuffer(commandPool);
+    } else {
+        batch.commandBuffer = allocateCommandBuffer(commandPool);
+    }
+
+    return batch;
+}
+
+VkCommandBuffer UploadQueue::allocateCommandBuffer(VkCommandPool pool) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate upload command buffer!");
+    }
+
+    return commandBuffer;
+}
+
+// the release half runs on the transfer queue after the copies, the acquire half on the queue that uses the data;
+// both describe the same destinations and layout transition
+void UploadQueue::recordOwnershipTransfer(VkCommandBuffer commandBuffer, bool isRelease) {
+    std::vector<VkBufferMemoryBarrier> bufferBarriers(pendingCopies.size());
+
+    for (size_t i = 0; i < pendingCopies.size(); i++) {
+        VkBufferMemoryBarrier& bufferBarrier = bufferBarriers[i];
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.srcAccessMask = isRelease ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+        bufferBarrier.dstAccessMask = isRelease ? 0 : CONSUMER_ACCESS;
+        bufferBarrier.srcQueueFamilyIndex = transferQueue.queueFamilyIndex;
+        bufferBarrier.dstQueueFamilyIndex = queueFamilyIndex;
+        bufferBarrier.buffer = pendingCopies[i].dstBuffer;
+        bufferBarrier.offset = pendingCopies[i].region.dstOffset;
+        bufferBarrier.size = pendingCopies[i].region.size;
+    }
+
+    std::vector<VkImageMemoryBarrier> imageBarriers(pendingImageCopies.size());
+
+    for (size_t i = 0; i < pendingImageCopies.size(); i++) {
+        VkImageMemoryBarrier& imageBarrier = imageBarriers[i];
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = isRelease ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+        imageBarrier.dstAccessMask = isRelease ? 0 : VK_ACCESS_SHADER_READ_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = transferQueue.queueFamilyIndex;
+        imageBarrier.dstQueueFamilyIndex = queueFamilyIndex;
+        imageBarrier.image = pendingImageCopies[i].dstImage;
+        imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    }
+
+    // the acquire waits for the transfer timeline at CONSUMER_STAGES, which its barrier continues from
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        isRelease ? VK_PIPELINE_STAGE_TRANSFER_BIT : CONSUMER_STAGES,
+        isRelease ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : CONSUMER_STAGES,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+    );
+}
+
+void UploadQueue::flush(GpuProfiler* profiler) {
+    if (pendingCopies.empty() && pendingImageCopies.empty()) {
+        return;
+    }
+
+    Batch batch = acquireBatch();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+    // the profiler's queries belong to the graphics queue
+    if (hasTransferQueue()) {
+        profiler = nullptr;
+    }
+
+    if (profiler) {
+        profiler->beginScope(batch.commandBuffer, "upload");
+    }
+
+    // images go from whatever they were to transfer destination and, after the copy, to shader read-only
+    std::vector<VkImageMemoryBarrier> imageBarriers(pendingImageCopies.size());
+
+    for (size_t i = 0; i < pendingImageCopies.size(); i++) {
+        VkImageMemoryBarrier& imageBarrier = imageBarriers[i];
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = 0;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = pendingImageCopies[i].dstImage;
+        imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    }
+
+    if (!hasTransferQueue()) {
+        // on the same queue, the copies must not overwrite buffers that work submitted before the batch is still
+        // reading; an execution dependency is enough for a write after a read. The transfer queue is not ordered with
+        // that work at all, see uploadBuffer().
+        vkCmdPipelineBarrier(batch.commandBuffer, CONSUMER_STAGES, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    } else if (!imageBarriers.empty()) {
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    // copies keep the order they were queued in, so a later write to a range wins; consecutive copies between the same
+    // buffers share one vkCmdCopyBuffer as long as none of its destination regions overlap
+    std::vector<VkBufferCopy> regions;
+
+    for (size_t i = 0; i < pendingCopies.size();) {
+        size_t j = i;
+        regions.clear();
+
+        while (j < pendingCopies.size() && pendingCopies[j].srcBuffer == pendingCopies[i].srcBuffer && pendingCopies[j].dstBuffer == pendingCopies[i].dstBuffer) {
+            const VkBufferCopy& region = pendingCopies[j].region;
+
+            bool isOverlapping = std::any_of(regions.begin(), regions.end(), [&](const VkBufferCopy& other) {
+                return region.dstOffset < other.dstOffset + other.size && other.dstOffset < region.dstOffset + region.size;
+            });
+
+            if (isOverlapping) {
+                break;
+            }
+
+            regions.push_back(region);
+            j++;
+        }
+
+        vkCmdCopyBuffer(batch.commandBuffer, pendingCopies[i].srcBuffer, pendingCopies[i].dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+        i = j;
+    }
+
+    for (const auto& imageCopy : pendingImageCopies) {
+        vkCmdCopyBufferToImage(batch.commandBuffer, imageCopy.srcBuffer, imageCopy.dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopy.region);
+    }
+
+    if (hasTransferQueue()) {
+        recordOwnershipTransfer(batch.commandBuffer, true);
+    } else {
+        for (auto& imageBarrier : imageBarriers) {
+            imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+
+        // make the copies visible to whatever is submitted to this queue after the batch
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = CONSUMER_ACCESS;
+
+        vkCmdPipelineBarrier(
+            batch.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            CONSUMER_STAGES,
+            0,
+            1, &barrier,
+            0, nullptr,
+            static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+        );
+    }
+
+    if (profiler) {
+        profiler->endScope(batch.commandBuffer);
+    }
+
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+    if (!hasTransferQueue()) {
+        if (timeline.submit(queue, submitInfo, batch.timelineValue) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload batch!");
+        }
+    } else {
+        uint64_t transferValue;
+
+        if (transferQueue.timeline->submit(transferQueue.queue, submitInfo, transferValue) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload batch!");
+        }
+
+        // only what is submitted after the acquire waits for the copies; the frames already
+        // submitted keep rendering while they run
+        vkBeginCommandBuffer(batch.acquireCommandBuffer, &beginInfo);
+        recordOwnershipTransfer(batch.acquireCommandBuffer, false);
+        vkEndCommandBuffer(batch.acquireCommandBuffer);
+
+        VkSubmitInfo acquireSubmitInfo{};
+        acquireSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireSubmitInfo.commandBufferCount = 1;
+        acquireSubmitInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+
+        if (timeline.submit(queue, acquireSubmitInfo, batch.timelineValue, { { transferQueue.timeline, transferValue, CONSUMER_STAGES } }) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload ownership transfer!");
+        }
+    }
+
+    batch.lastTicket = lastTicket;
+    batch.ringEnd = head;
+
+    submittedTicket = lastTicket;
+    submittedBytes += pendingBytes;
+    pendingBytes = 0;
+    batch.oversizedStaging = std::move(pendingOversizedStaging);
+
+    pendingCopies.clear();
+    pendingImageCopies.clear();
+    pendingOversizedStaging.clear();
+
+    inFlightBatches.push_back(std::move(batch));
+}
+
+void UploadQueue::retireOldest() {
+    Batch batch = std::move(inFlightBatches.front());
+    inFlightBatches.pop_front();
+
+    // batches complete in submission order, so the ring is released front to back
+    tail = batch.ringEnd;
+    completedTicket = batch.lastTicket;
+
+    for (auto& staging : batch.oversizedStaging) {
+        destroyBuffer(device, allocator, staging.buffer, staging.allocation);
+    }
+
+    batch.oversizedStaging.clear();
+
+    freeBatches.push_back(std::move(batch));
+}
+
+void UploadQueue::poll() {
+    while (!inFlightBatches.empty() && timeline.isComplete(inFlightBatches.front().timelineValue)) {
+        retireOldest();
+    }
+}
+
+bool UploadQueue::isComplete(uint64_t ticket) {
+    if (ticket > completedTicket) {
+        poll();
+    }
+
+    return ticket <= completedTicket;
+}
+
+void UploadQueue::wait(uint64_t ticket) {
+    if (ticket <= completedTicket) {
+        return;
+    }
+
+    if (ticket > submittedTicket) {
+        flush();
+    }
+
+    // wait for the batch holding the ticket only, then retire it and every batch before it
+    for (const auto& batch : inFlightBatches) {
+        if (batch.lastTicket >= ticket) {
+            timeline.wait(batch.timelineValue);
+            break;
+        }
+    }
+
+    poll();
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "memory_allocator.h"
+#include "timeline_scheduler.h"
+
+class GpuProfiler;
+class UploadQueue;
+
+// Future-like handle for an upload: ready once the batch it was recorded into has finished on the GPU.
+class UploadHandle {
+public:
+    UploadHandle() = default;
+    UploadHandle(UploadQueue* queue, uint64_t ticket) : queue(queue), ticket(ticket) {}
+
+    bool isReady() const;
+    void wait() const;
+
+private:
+    UploadQueue* queue = nullptr;
+    uint64_t ticket = 0;
+};
+
+// Persistently mapped staging ring. Uploads are copied into the ring right away and recorded into
+// one command buffer per flush(), which is submitted on the timeline; the ring space of a batch is
+// reclaimed once the timeline reaches the batch's value.
+//
+// With a dedicated transfer queue, the copies run there instead, and a second, small command buffer on the queue
+// that uses the data acquires the destinations from the transfer queue family once the copies are done.
+class UploadQueue {
+public:
+    static constexpr VkDeviceSize DEFAULT_CAPACITY = 16ull * 1024 * 1024;
+
+    struct TransferQueue {
+        VkQueue queue;
+        uint32_t queueFamilyIndex;
+        TimelineScheduler* timeline;
+    };
+
+    // queue is the one that uses the uploaded data; transferQueue is optional
+    UploadQueue(VkDevice device, DeviceMemoryAllocator& allocator, TimelineScheduler& timeline, VkQueue queue, uint32_t queueFamilyIndex, const TransferQueue* transferQueue = nullptr, VkDeviceSize capacity = DEFAULT_CAPACITY);
+    ~UploadQueue();
+
+    UploadQueue(const UploadQueue&) = delete;
+    UploadQueue& operator=(const UploadQueue&) = delete;
+
+    // uploads to the same range land in the order they were made. On the queue that uses the data, the copies wait for
+    // the reads submitted before the flush; the transfer queue does not, so there the range must not be in use by work
+    // in flight.
+    UploadHandle uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+    // fills mip level 0 of a single-layer color image with tightly packed texels; the previous contents are discarded
+    // and the image ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    UploadHandle uploadImage(VkImage dstImage, VkExtent2D extent, const void* data, VkDeviceSize size);
+
+    // records and submits everything queued since the last flush; commands submitted to the same
+    // queue afterwards see the uploaded data. With a profiler, the copies are timed as an "upload" scope,
+    // unless they run on the transfer queue, which the profiler's queries don't belong to.
+    void flush(GpuProfiler* profiler = nullptr);
+
+    // reclaims the ring space of completed batches without blocking
+    void poll();
+
+    bool isComplete(uint64_t ticket);
+    void wait(uint64_t ticket);
+
+    bool hasTransferQueue() const { return transferCommandPool != VK_NULL_HANDLE; }
+
+    // bytes copied by the batches submitted so far
+    uint64_t getSubmittedBytes() const { return submittedBytes; }
+
+private:
+    struct PendingCopy {
+        VkBuffer srcBuffer;
+        VkBuffer dstBuffer;
+        VkBufferCopy region;
+    };
+
+    struct PendingImageCopy {
+        VkBuffer srcBuffer;
+        VkImage dstImage;
+        VkBufferImageCopy region;
+    };
+
+    struct OversizedStaging {
+        VkBuffer buffer;
+        Allocation allocation;
+    };
+
+    struct Batch {
+        VkCommandBuffer commandBuffer;
+        // with a transfer queue: the ownership acquire, on the queue that uses the data
+        VkCommandBuffer acquireCommandBuffer;
+        uint64_t timelineValue;
+        uint64_t lastTicket;
+        VkDeviceSize ringEnd;
+        std::vector<OversizedStaging> oversizedStaging;
+    };
+
+    bool allocateRing(VkDeviceSize size, VkDeviceSize& offset);
+    void stage(const void* data, VkDeviceSize size, VkBuffer& srcBuffer, VkDeviceSize& srcOffset);
+    void retireOldest();
+    Batch acquireBatch();
+    VkCommandBuffer allocateCommandBuffer(VkCommandPool pool);
+    void recordOwnershipTransfer(VkCommandBuffer commandBuffer, bool isRelease);
+
+    VkDevice device;
+    DeviceMemoryAllocator& allocator;
+    TimelineScheduler& timeline;
+    VkQueue queue;
+    uint32_t queueFamilyIndex;
+    VkCommandPool commandPool;
+
+    TransferQueue transferQueue{};
+    VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+
+    VkBuffer ringBuffer;
+    Allocation ringAllocation;
+    VkDeviceSize capacity;
+    VkDeviceSize head = 0;
+    VkDeviceSize tail = 0;
+
+    std::vector<PendingCopy> pendingCopies;
+    std::vector<PendingImageCopy> pendingImageCopies;
+    std::vector<OversizedStaging> pendingOversizedStaging;
+
+    std::deque<Batch> inFlightBatches;
+    std::vector<Batch> freeBatches;
+
+    uint64_t lastTicket = 0;
+    uint64_t submittedTicket = 0;
+    uint64_t completedTicket = 0;
+
+    VkDeviceSize pendingBytes = 0;
+    uint64_t submittedBytes = 0;
+};